@@ -0,0 +1,142 @@
+#include "AssignmentBenchmark.h"
+
+#include <cstdio>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "opencv2/imgproc.hpp"
+
+#include "munkres.h"
+#include "LapJV.h"
+
+static cv::Mat make_tracker_cost_table(size_t tracks_count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> pos_x(0.0, 1920.0);
+	std::uniform_real_distribution<double> pos_y(0.0, 1080.0);
+	std::uniform_real_distribution<double> plate_diag(40.0, 160.0);
+	std::uniform_real_distribution<double> speed(0.0, 0.8);
+	std::normal_distribution<double> noise(0.0, 0.1);
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+	struct TrackState
+	{
+		cv::Point2d end;
+		cv::Point2d velocity;
+		double diag;
+	};
+
+	std::vector<TrackState> tracks(tracks_count);
+	std::vector<cv::Point2d> plates;
+
+	for (auto& t : tracks)
+	{
+		t.end = cv::Point2d(pos_x(rng), pos_y(rng));
+		t.diag = plate_diag(rng);
+		t.velocity = cv::Point2d(noise(rng) * t.diag, speed(rng) * t.diag);
+
+		// Detection of track with 10% miss rate
+		if (chance(rng) > 0.1)
+			plates.push_back(t.end + t.velocity + cv::Point2d(noise(rng), noise(rng)) * t.diag);
+	}
+
+	// False positives and new vehicles
+	const size_t extra_plates = tracks_count / 5 + 1;
+	for (size_t i = 0; i < extra_plates; ++i)
+		plates.push_back(cv::Point2d(pos_x(rng), pos_y(rng)));
+
+	std::shuffle(plates.begin(), plates.end(), rng);
+
+	// Same weighting as in LPTrackAssociator::process
+	cv::Mat table(static_cast<int>(tracks.size()), static_cast<int>(plates.size()), CV_64FC1);
+
+	for (size_t i = 0; i < tracks.size(); ++i)
+		for (size_t j = 0; j < plates.size(); ++j)
+		{
+			const double max_dist = 2.0 * tracks[i].diag;
+			const double distance = cv::norm(plates[j] - tracks[i].end);
+
+			double angle = 0.0;
+			const cv::Point2d tar_vec = plates[j] - tracks[i].end;
+			const double len_mult = cv::norm(tracks[i].velocity) * cv::norm(tar_vec);
+			if (len_mult > DBL_EPSILON)
+				angle = std::acos(std::max(-1.0, std::min(1.0, tracks[i].velocity.dot(tar_vec) / len_mult))) * 57.295779513;
+
+			double weight = 0.4 * (distance / max_dist) + 0.4 * (angle / 30.0);
+			if (distance > 1.5 * max_dist)
+				weight = 100.0;
+
+			table.at<double>(static_cast<int>(i), static_cast<int>(j)) = weight + 1.0;
+		}
+
+	return table;
+};
+
+static double assignment_cost(const cv::Mat& table, const cv::Mat& res)
+{
+	double cost = 0.0;
+
+	for (int i = 0; i < res.rows; ++i)
+		for (int j = 0; j < res.cols; ++j)
+			if (res.at<int>(i, j) == 0)
+				cost += table.at<double>(i, j);
+
+	return cost;
+};
+
+void benchmark_assignment_solvers(size_t iterations)
+{
+	const size_t sizes[] = { 2, 4, 8, 16, 32, 64 };
+
+	for (auto tracks_count : sizes)
+	{
+		std::mt19937 rng(static_cast<unsigned int>(tracks_count));
+		std::vector<cv::Mat> tables(iterations);
+
+		for (auto& table : tables)
+			table = make_tracker_cost_table(tracks_count, rng);
+
+		double munkres_cost = 0.0, lapjv_cost = 0.0;
+		size_t mismatches = 0;
+
+		// Munkres: one solver for all tables, as LapJV below
+		auto start = std::chrono::high_resolution_clock::now();
+		Munkres<double> hungarian;
+		std::vector<cv::Mat> munkres_results(iterations);
+
+		for (size_t i = 0; i < iterations; ++i)
+			munkres_results[i] = hungarian.solve(tables[i]);
+
+		auto munkres_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// LapJV
+		start = std::chrono::high_resolution_clock::now();
+		LapJV<double> lapjv;
+		std::vector<cv::Mat> lapjv_results(iterations);
+
+		for (size_t i = 0; i < iterations; ++i)
+			lapjv_results[i] = lapjv.solve(tables[i]);
+
+		auto lapjv_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// Both solvers are exact, total costs must be equal
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			const double c1 = assignment_cost(tables[i], munkres_results[i]);
+			const double c2 = assignment_cost(tables[i], lapjv_results[i]);
+
+			munkres_cost += c1;
+			lapjv_cost += c2;
+
+			if (abs(c1 - c2) > 1e-6)
+				++mismatches;
+		}
+
+		printf("tracks = %3u: munkres = %8.2f us, lapjv = %8.2f us, speedup = %5.1f, cost mismatches = %u \r\n",
+			static_cast<unsigned int>(tracks_count),
+			static_cast<double>(munkres_time) / iterations,
+			static_cast<double>(lapjv_time) / iterations,
+			static_cast<double>(munkres_time) / std::max<long long>(lapjv_time, 1),
+			static_cast<unsigned int>(mismatches));
+	}
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Compares Munkres and LapJV solvers on cost tables similar to LPTracker ones:
+// tracks with random velocity, missed detections, false positives and gated pairs.
+
+void benchmark_assignment_solvers(size_t iterations);
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <condition_variable>
+
+// Bounded multi-producer/multi-consumer queue.
+// push() waits while the queue is full, pop() waits while it is empty.
+// close() wakes all waiting threads: pushes fail, pops drain the rest and then fail.
+// Every successful pop gets a ticket: sequential number in pop order.
+
+template<typename T>
+class BlockingQueue
+{
+private:
+	std::deque<T> m_items;
+	size_t m_capacity;
+	size_t m_next_ticket;
+	bool m_is_closed;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_not_empty;
+	std::condition_variable m_not_full;
+
+public:
+	explicit BlockingQueue(size_t capacity)
+	{
+		m_capacity = capacity > 0 ? capacity : 1;
+		m_next_ticket = 0;
+		m_is_closed = false;
+	}
+
+	BlockingQueue(const BlockingQueue&) = delete;
+	BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+	bool push(T&& item)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_full.wait(lock, [this] { return m_is_closed || m_items.size() < m_capacity; });
+
+			if (m_is_closed)
+				return false;
+
+			m_items.push_back(std::move(item));
+		}
+
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	bool try_push(T&& item)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_is_closed || m_items.size() >= m_capacity)
+				return false;
+
+			m_items.push_back(std::move(item));
+		}
+
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	// Never waits: the oldest item is dropped if the queue is full. Returns false if the queue is closed.
+	bool push_evict(T&& item, bool& is_evicted)
+	{
+		is_evicted = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_is_closed)
+				return false;
+
+			if (m_items.size() >= m_capacity)
+			{
+				m_items.pop_front();
+				is_evicted = true;
+			}
+
+			m_items.push_back(std::move(item));
+		}
+
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	bool pop(T& item)
+	{
+		size_t ticket;
+		return pop(item, ticket);
+	}
+
+	bool pop(T& item, size_t& ticket)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_empty.wait(lock, [this] { return m_is_closed || !m_items.empty(); });
+
+			if (m_items.empty())
+				return false;
+
+			item = std::move(m_items.front());
+			m_items.pop_front();
+			ticket = m_next_ticket++;
+		}
+
+		m_not_full.notify_one();
+		return true;
+	}
+
+	bool try_pop(T& item)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_items.empty())
+				return false;
+
+			item = std::move(m_items.front());
+			m_items.pop_front();
+			++m_next_ticket;
+		}
+
+		m_not_full.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_is_closed = true;
+		}
+
+		m_not_empty.notify_all();
+		m_not_full.notify_all();
+	}
+
+	// Clears items and tickets and opens the queue again
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_items.clear();
+		m_next_ticket = 0;
+		m_is_closed = false;
+	}
+
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_items.size();
+	}
+
+	size_t capacity() const
+	{
+		return m_capacity;
+	}
+};
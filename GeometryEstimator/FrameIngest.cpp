@@ -0,0 +1,105 @@
+#include "FrameIngest.h"
+
+#include <chrono>
+
+FrameIngest::FrameIngest(Policy policy, size_t nth)
+{
+	set_policy(policy, nth);
+	m_next_sequence.store(0);
+	reset_stats();
+};
+
+void FrameIngest::set_policy(Policy policy, size_t nth)
+{
+	m_policy.store(policy);
+	m_nth.store(nth > 0 ? nth : 1);
+};
+
+FrameIngest::Policy FrameIngest::policy() const
+{
+	return m_policy.load();
+};
+
+size_t FrameIngest::nth() const
+{
+	return m_nth.load();
+};
+
+uint64_t FrameIngest::next_sequence()
+{
+	++m_captured;
+	return m_next_sequence++;
+};
+
+FrameTag FrameIngest::next_tag()
+{
+	FrameTag tag;
+	tag.timestamp = now();
+	tag.sequence = next_sequence();
+	return tag;
+};
+
+FrameTag FrameIngest::injected_tag()
+{
+	FrameTag tag;
+	tag.timestamp = now();
+	tag.sequence = m_next_sequence++;
+	return tag;
+};
+
+int64_t FrameIngest::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+};
+
+int64_t FrameIngest::to_system_ms(int64_t timestamp)
+{
+	const auto system_now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	return system_now - (now() - timestamp) / 1000;
+};
+
+bool FrameIngest::is_skipped(uint64_t sequence)
+{
+	if (m_policy.load() != Policy::every_nth || sequence % m_nth.load() == 0)
+		return false;
+
+	++m_skipped;
+	return true;
+};
+
+bool FrameIngest::evicts_when_full() const
+{
+	return m_policy.load() == Policy::latest_wins;
+};
+
+void FrameIngest::count_rejected()
+{
+	++m_rejected;
+};
+
+void FrameIngest::count_evicted()
+{
+	++m_evicted;
+};
+
+FrameIngest::Stats FrameIngest::stats() const
+{
+	// Drops are loaded first: a frame is counted as captured before it is dropped
+	Stats stats;
+	stats.skipped = m_skipped.load();
+	stats.rejected = m_rejected.load();
+	stats.evicted = m_evicted.load();
+	stats.captured = m_captured.load();
+
+	// Evicted frames were accepted first
+	stats.accepted = stats.captured - stats.skipped - stats.rejected;
+	return stats;
+};
+
+void FrameIngest::reset_stats()
+{
+	m_captured.store(0);
+	m_skipped.store(0);
+	m_rejected.store(0);
+	m_evicted.store(0);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Identity of a frame through the pipeline: ingest sequence number and
+// monotonic ingest time (microseconds of steady clock, see FrameIngest::now()).
+struct FrameTag
+{
+	uint64_t sequence = 0;
+	int64_t timestamp = 0;
+};
+
+// Frame ingest policy and drop accounting.
+// Every captured frame gets a sequence number, dropped frames are counted by reason:
+//   latest_wins  - queue full: the oldest waiting frame is evicted;
+//   bounded_fifo - queue full: the new frame is rejected;
+//   every_nth    - only every Nth frame is taken, queue full: the new frame is rejected.
+
+class FrameIngest
+{
+public:
+	enum class Policy
+	{
+		latest_wins,
+		bounded_fifo,
+		every_nth
+	};
+
+	struct Stats
+	{
+		size_t captured = 0;
+		size_t accepted = 0;
+		size_t skipped = 0;
+		size_t rejected = 0;
+		size_t evicted = 0;
+
+		size_t dropped() const { return skipped + rejected + evicted; }
+	};
+
+private:
+	std::atomic<Policy> m_policy;
+	std::atomic<size_t> m_nth;
+	std::atomic<uint64_t> m_next_sequence;
+
+	std::atomic<size_t> m_captured;
+	std::atomic<size_t> m_skipped;
+	std::atomic<size_t> m_rejected;
+	std::atomic<size_t> m_evicted;
+
+public:
+	FrameIngest(Policy policy = Policy::latest_wins, size_t nth = 1);
+	~FrameIngest() = default;
+
+	void set_policy(Policy policy, size_t nth = 1);
+	Policy policy() const;
+	size_t nth() const;
+
+	// Capture side: sequence of new frame and decision whether it is taken at all
+	uint64_t next_sequence();
+	FrameTag next_tag();
+	bool is_skipped(uint64_t sequence);
+	bool evicts_when_full() const;
+	void count_rejected();
+	void count_evicted();
+
+	// Tag of a frame injected past capture (detections given by caller), not counted in stats
+	FrameTag injected_tag();
+
+	Stats stats() const;
+	void reset_stats();
+
+	// Monotonic time in microseconds
+	static int64_t now();
+
+	// Converts monotonic time to milliseconds since epoch
+	static int64_t to_system_ms(int64_t timestamp);
+};
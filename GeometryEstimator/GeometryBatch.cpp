@@ -0,0 +1,420 @@
+#include "GeometryBatch.h"
+
+#if GEOMETRY_SSE2
+#include <emmintrin.h>
+
+static inline __m128 abs_ps(__m128 x)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+};
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+};
+#endif
+
+void PointBatch::clear()
+{
+	x.clear();
+	y.clear();
+};
+
+void PointBatch::assign(const std::vector<cv::Point2f>& points)
+{
+	x.resize(points.size());
+	y.resize(points.size());
+
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+	}
+};
+
+void PointBatch::push_back(const cv::Point2f& point)
+{
+	x.push_back(point.x);
+	y.push_back(point.y);
+};
+
+size_t PointBatch::size() const
+{
+	return x.size();
+};
+
+cv::Point2f PointBatch::point(size_t i) const
+{
+	return cv::Point2f(x[i], y[i]);
+};
+
+void LineBatch::clear()
+{
+	a.clear();
+	b.clear();
+	c.clear();
+	mid_x.clear();
+	mid_y.clear();
+	length.clear();
+	x_min.clear();
+	x_max.clear();
+};
+
+void LineBatch::assign(const std::vector<LineF>& lines)
+{
+	clear();
+
+	for (const auto& line : lines)
+		push_back(line);
+};
+
+void LineBatch::push_back(const LineF& line)
+{
+	float la = 0.0f, lb = 0.0f, lc = 0.0f;
+	normalizeLine(line, la, lb, lc);
+
+	a.push_back(la);
+	b.push_back(lb);
+	c.push_back(lc);
+	mid_x.push_back((line.p1.x + line.p2.x) / 2.0f);
+	mid_y.push_back((line.p1.y + line.p2.y) / 2.0f);
+	length.push_back(static_cast<float>(line.length()));
+	x_min.push_back(std::min(line.p1.x, line.p2.x));
+	x_max.push_back(std::max(line.p1.x, line.p2.x));
+};
+
+size_t LineBatch::size() const
+{
+	return a.size();
+};
+
+bool normalizeLine(const LineF& line, float& a, float& b, float& c)
+{
+	const float denominator = sqrt(line.A() * line.A() + line.B() * line.B());
+	if (abs(denominator) < FLT_EPSILON)
+	{
+		a = b = c = 0.0f;
+		return false;
+	}
+
+	a = line.A() / denominator;
+	b = line.B() / denominator;
+	c = line.C() / denominator;
+	return true;
+};
+
+void pointLineDistances(float a, float b, float c, const PointBatch& points, std::vector<float>& distances)
+{
+	const size_t n = points.size();
+	distances.resize(n);
+	size_t i = 0;
+
+#if GEOMETRY_SSE2
+	const __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b), vc = _mm_set1_ps(c);
+
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 rho = _mm_add_ps(_mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(&points.x[i])), _mm_mul_ps(vb, _mm_loadu_ps(&points.y[i]))), vc);
+		_mm_storeu_ps(&distances[i], abs_ps(rho));
+	}
+#endif
+
+	for (; i < n; ++i)
+		distances[i] = abs(a * points.x[i] + b * points.y[i] + c);
+};
+
+size_t countLineInliers(float a, float b, float c, float thresh, const PointBatch& points)
+{
+	const size_t n = points.size();
+	size_t inliers_count = 0;
+	size_t i = 0;
+
+#if GEOMETRY_SSE2
+	const __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b), vc = _mm_set1_ps(c);
+	const __m128 vthresh = _mm_set1_ps(thresh);
+	__m128i vcount = _mm_setzero_si128();
+
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 rho = _mm_add_ps(_mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(&points.x[i])), _mm_mul_ps(vb, _mm_loadu_ps(&points.y[i]))), vc);
+
+		// Mask lanes are -1
+		vcount = _mm_sub_epi32(vcount, _mm_castps_si128(_mm_cmplt_ps(abs_ps(rho), vthresh)));
+	}
+
+	int counts[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(counts), vcount);
+	inliers_count = counts[0] + counts[1] + counts[2] + counts[3];
+#endif
+
+	for (; i < n; ++i)
+		if (abs(a * points.x[i] + b * points.y[i] + c) < thresh)
+			++inliers_count;
+
+	return inliers_count;
+};
+
+void intersectLines(const LineBatch& lines, size_t i, float y_max, PointBatch& intersections)
+{
+	const size_t n = lines.size();
+	const float ai = lines.a[i], bi = lines.b[i], ci = lines.c[i];
+	const float xi_min = lines.x_min[i], xi_max = lines.x_max[i];
+	size_t j = i + 1;
+
+#if GEOMETRY_SSE2
+	const __m128 vai = _mm_set1_ps(ai), vbi = _mm_set1_ps(bi), vci = _mm_set1_ps(ci);
+	const __m128 vxi_min = _mm_set1_ps(xi_min), vxi_max = _mm_set1_ps(xi_max);
+	const __m128 veps = _mm_set1_ps(FLT_EPSILON), vy_max = _mm_set1_ps(y_max);
+	float xs[4], ys[4];
+
+	for (; j + 4 <= n; j += 4)
+	{
+		const __m128 aj = _mm_loadu_ps(&lines.a[j]), bj = _mm_loadu_ps(&lines.b[j]), cj = _mm_loadu_ps(&lines.c[j]);
+		const __m128 d = _mm_sub_ps(_mm_mul_ps(vai, bj), _mm_mul_ps(vbi, aj));
+		const __m128 is_crossing = _mm_cmpge_ps(abs_ps(d), veps);
+
+		// Parallel lanes are divided by one and masked out
+		const __m128 d_safe = select_ps(is_crossing, d, _mm_set1_ps(1.0f));
+		const __m128 x = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(vbi, cj), _mm_mul_ps(vci, bj)), d_safe);
+		const __m128 y = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(vci, aj), _mm_mul_ps(vai, cj)), d_safe);
+
+		const __m128 between_i = _mm_and_ps(_mm_cmpgt_ps(x, vxi_min), _mm_cmplt_ps(x, vxi_max));
+		const __m128 between_j = _mm_and_ps(_mm_cmpgt_ps(x, _mm_loadu_ps(&lines.x_min[j])), _mm_cmplt_ps(x, _mm_loadu_ps(&lines.x_max[j])));
+		const __m128 valid = _mm_and_ps(_mm_andnot_ps(_mm_or_ps(between_i, between_j), is_crossing), _mm_cmplt_ps(y, vy_max));
+
+		const int mask = _mm_movemask_ps(valid);
+		if (mask == 0)
+			continue;
+
+		_mm_storeu_ps(xs, x);
+		_mm_storeu_ps(ys, y);
+
+		for (int k = 0; k < 4; ++k)
+			if (mask & (1 << k))
+				intersections.push_back(cv::Point2f(xs[k], ys[k]));
+	}
+#endif
+
+	for (; j < n; ++j)
+	{
+		const float d = ai * lines.b[j] - bi * lines.a[j];
+		if (abs(d) < FLT_EPSILON)
+			continue;
+
+		const float x = (bi * lines.c[j] - ci * lines.b[j]) / d;
+		const float y = (ci * lines.a[j] - ai * lines.c[j]) / d;
+
+		const bool between_i = x > xi_min && x < xi_max;
+		const bool between_j = x > lines.x_min[j] && x < lines.x_max[j];
+
+		if (!between_i && !between_j && y < y_max)
+			intersections.push_back(cv::Point2f(x, y));
+	}
+};
+
+// Angle in degrees from its sine: asin series, error below 1e-4 degree up to 30 degrees
+static inline float angleFromSine(float s)
+{
+	const float s2 = s * s;
+	return static_cast<float>(DEGRAD) * s * (1.0f + s2 * (1.0f / 6.0f + s2 * (3.0f / 40.0f + s2 * (5.0f / 112.0f))));
+};
+
+#if GEOMETRY_SSE2
+// Rother weights of 4 pairs of line (unit normal a, b and length) and vector dx, dy from the line middle to the point,
+// zero outside of the line cone
+static inline __m128 rotherWeight_ps(__m128 a, __m128 b, __m128 length, __m128 dx, __m128 dy, float cos_max_ang2, float coef_len)
+{
+	const __m128 c1 = _mm_set1_ps(1.0f), c3 = _mm_set1_ps(1.0f / 6.0f), c5 = _mm_set1_ps(3.0f / 40.0f), c7 = _mm_set1_ps(5.0f / 112.0f);
+
+	// Components of the vector along and across the line
+	const __m128 dot = _mm_sub_ps(_mm_mul_ps(a, dy), _mm_mul_ps(b, dx));
+	const __m128 cross = _mm_add_ps(_mm_mul_ps(a, dx), _mm_mul_ps(b, dy));
+	const __m128 norm2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+	const __m128 close = _mm_cmpgt_ps(_mm_mul_ps(dot, dot), _mm_mul_ps(_mm_set1_ps(cos_max_ang2), norm2));
+	if (_mm_movemask_ps(close) == 0)
+		return _mm_setzero_ps();
+
+	// Far lanes have zero norm only if they are masked out
+	const __m128 sine = _mm_div_ps(abs_ps(cross), _mm_sqrt_ps(select_ps(close, norm2, c1)));
+	const __m128 s2 = _mm_mul_ps(sine, sine);
+	const __m128 series = _mm_add_ps(c1, _mm_mul_ps(s2, _mm_add_ps(c3, _mm_mul_ps(s2, _mm_add_ps(c5, _mm_mul_ps(s2, c7))))));
+	const __m128 dangle = _mm_mul_ps(_mm_set1_ps(static_cast<float>(DEGRAD)), _mm_mul_ps(sine, series));
+
+	const __m128 w = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(static_cast<float>(ROTHER_COEF_ANG)), _mm_mul_ps(_mm_set1_ps(static_cast<float>(ROTHER_COEF_ANG / ROTHER_MAX_ANG)), dangle)),
+								_mm_mul_ps(_mm_set1_ps(coef_len), length));
+	return _mm_and_ps(close, w);
+};
+#endif
+
+// Rother weight of line i for vector dx, dy from its middle to the point, zero outside of the line cone
+static inline float rotherWeight(const LineBatch& lines, size_t i, float dx, float dy, float cos_max_ang2, float coef_len)
+{
+	const float dot = lines.a[i] * dy - lines.b[i] * dx;
+	const float norm2 = dx * dx + dy * dy;
+
+	if (dot * dot <= cos_max_ang2 * norm2)
+		return 0.0f;
+
+	const float cross = lines.a[i] * dx + lines.b[i] * dy;
+	const float dangle = angleFromSine(abs(cross) / sqrt(norm2));
+
+	return static_cast<float>(ROTHER_COEF_ANG) - static_cast<float>(ROTHER_COEF_ANG / ROTHER_MAX_ANG) * dangle + coef_len * lines.length[i];
+};
+
+double rotherWeights(const LineBatch& lines, size_t begin, size_t end, const cv::Point2f& point, double length_max)
+{
+	// Angle between lines is below max angle: dot^2 > cos^2 * |v|^2, normal of line is unit
+	static const float cos_max_ang2 = static_cast<float>(cos(ROTHER_MAX_ANG / DEGRAD) * cos(ROTHER_MAX_ANG / DEGRAD));
+
+	const float coef_len = static_cast<float>(ROTHER_COEF_LEN / length_max);
+
+	double weight = 0.0;
+	size_t i = begin;
+
+#if GEOMETRY_SSE2
+	const __m128 vx = _mm_set1_ps(point.x), vy = _mm_set1_ps(point.y);
+	__m128 vweight = _mm_setzero_ps();
+
+	// 4 lines at once
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 dx = _mm_sub_ps(vx, _mm_loadu_ps(&lines.mid_x[i]));
+		const __m128 dy = _mm_sub_ps(vy, _mm_loadu_ps(&lines.mid_y[i]));
+		const __m128 w = rotherWeight_ps(_mm_loadu_ps(&lines.a[i]), _mm_loadu_ps(&lines.b[i]), _mm_loadu_ps(&lines.length[i]), dx, dy, cos_max_ang2, coef_len);
+		vweight = _mm_add_ps(vweight, w);
+	}
+
+	float weights[4];
+	_mm_storeu_ps(weights, vweight);
+	weight = static_cast<double>(weights[0]) + weights[1] + weights[2] + weights[3];
+#endif
+
+	for (; i < end; ++i)
+		weight += rotherWeight(lines, i, point.x - lines.mid_x[i], point.y - lines.mid_y[i], cos_max_ang2, coef_len);
+
+	return weight;
+};
+
+void rotherVoteCells(const LineBatch& lines, size_t i, const cv::Point2d& origin, const cv::Point2d& cell_size, int cols, int rows,
+					 float y_max, double length_max, double* votes, int* best_cell)
+{
+	static const double cos_max_ang = cos(ROTHER_MAX_ANG / DEGRAD);
+	static const double sin_max_ang = sin(ROTHER_MAX_ANG / DEGRAD);
+
+	const float cos_max_ang2 = static_cast<float>(cos_max_ang * cos_max_ang);
+	const float coef_len = static_cast<float>(ROTHER_COEF_LEN / length_max);
+
+	// Degenerate line has zero normal and no cone
+	if (lines.a[i] == 0.0f && lines.b[i] == 0.0f)
+		return;
+
+	// Cone on row y = mid_y + v: u = x - mid_x solves A * u^2 + 2 * dir_x * dir_y * v * u + (dir_y^2 - cos^2) * v^2 >= 0,
+	// roots are (-dir_x * dir_y * v -+ |v| * cos * sin) / A. Cone is between roots for A < 0 and outside of them for A > 0
+	const double dir_x = -lines.b[i];
+	const double dir_y = lines.a[i];
+	const double a = dir_x * dir_x - cos_max_ang * cos_max_ang;
+
+	// Column of x, clamped to [-1, cols]
+	auto column = [&origin, &cell_size, cols](double x)
+	{
+		const double c = std::floor((x - origin.x) / cell_size.x);
+		return static_cast<int>(std::min(std::max(c, -1.0), static_cast<double>(cols)));
+	};
+
+	// Cell centers relative to the line middle: x = first_x + col * cell_width
+	const float first_x = static_cast<float>(origin.x + 0.5 * cell_size.x - lines.mid_x[i]);
+	const float cell_width = static_cast<float>(cell_size.x);
+
+	auto update_best = [votes, best_cell](int cell)
+	{
+		if (best_cell != nullptr && (*best_cell < 0 || votes[cell] > votes[*best_cell]))
+			*best_cell = cell;
+	};
+
+#if GEOMETRY_SSE2
+	const __m128 va = _mm_set1_ps(lines.a[i]), vb = _mm_set1_ps(lines.b[i]), vlength = _mm_set1_ps(lines.length[i]);
+	const __m128 vfirst_x = _mm_set1_ps(first_x), vcell_width = _mm_set1_ps(cell_width);
+	const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+	float weights[4];
+#endif
+
+	for (int row = 0; row < rows; ++row)
+	{
+		const double y = origin.y + (row + 0.5) * cell_size.y;
+		if (y >= y_max)
+			break;
+
+		// Up to two column ranges, widened by a cell: exact test is done per cell
+		int ranges[2][2] = { { 0, cols - 1 }, { 0, -1 } };
+
+		if (abs(a) > DBL_EPSILON)
+		{
+			const double v = y - lines.mid_y[i];
+			const double center = lines.mid_x[i] - dir_x * dir_y * v / a;
+			const double half = abs(v) * cos_max_ang * sin_max_ang / abs(a);
+
+			if (a < 0.0)
+			{
+				ranges[0][0] = column(center - half) - 1;
+				ranges[0][1] = column(center + half) + 1;
+			}
+			else
+			{
+				ranges[0][1] = column(center - half) + 1;
+				ranges[1][0] = column(center + half) - 1;
+				ranges[1][1] = cols - 1;
+
+				// Overlapping ranges are merged, so no cell votes twice
+				if (ranges[1][0] <= ranges[0][1])
+				{
+					ranges[0][1] = cols - 1;
+					ranges[1][1] = -1;
+				}
+			}
+		}
+
+		const float dy = static_cast<float>(y) - lines.mid_y[i];
+		double* row_votes = votes + static_cast<size_t>(row) * cols;
+
+		for (const auto& range : ranges)
+		{
+			const int end = std::min(range[1] + 1, cols);
+			int col = std::max(range[0], 0);
+
+#if GEOMETRY_SSE2
+			// 4 cells of the row at once, weights outside of the cone are zero
+			const __m128 vdy = _mm_set1_ps(dy);
+
+			for (; col + 4 <= end; col += 4)
+			{
+				const __m128 vcol = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(col), lanes));
+				const __m128 vdx = _mm_add_ps(vfirst_x, _mm_mul_ps(vcol, vcell_width));
+				const __m128 w = rotherWeight_ps(va, vb, vlength, vdx, vdy, cos_max_ang2, coef_len);
+
+				_mm_storeu_pd(row_votes + col, _mm_add_pd(_mm_loadu_pd(row_votes + col), _mm_cvtps_pd(w)));
+				_mm_storeu_pd(row_votes + col + 2, _mm_add_pd(_mm_loadu_pd(row_votes + col + 2), _mm_cvtps_pd(_mm_movehl_ps(w, w))));
+
+				if (best_cell != nullptr)
+				{
+					_mm_storeu_ps(weights, w);
+
+					for (int k = 0; k < 4; ++k)
+						if (weights[k] > 0.0f)
+							update_best(row * cols + col + k);
+				}
+			}
+#endif
+
+			for (; col < end; ++col)
+			{
+				const float weight = rotherWeight(lines, i, first_x + col * cell_width, dy, cos_max_ang2, coef_len);
+				if (weight <= 0.0f)
+					continue;
+
+				row_votes[col] += weight;
+				update_best(row * cols + col);
+			}
+		}
+	}
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+
+#include "GeometryCommon.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_SSE2 1
+#else
+#define GEOMETRY_SSE2 0
+#endif
+
+// Structure of arrays for geometry kernels: coordinates of 4 points or lines
+// are loaded into one SSE2 register, scalar code is used for tails and without SSE2.
+
+struct PointBatch
+{
+	std::vector<float> x;
+	std::vector<float> y;
+
+	void clear();
+	void assign(const std::vector<cv::Point2f>& points);
+	void push_back(const cv::Point2f& point);
+	size_t size() const;
+	cv::Point2f point(size_t i) const;
+};
+
+// Normalized equation a * x + b * y + c = 0 (a^2 + b^2 = 1, zero for degenerate lines),
+// middle point, length and x range of every segment
+struct LineBatch
+{
+	std::vector<float> a;
+	std::vector<float> b;
+	std::vector<float> c;
+	std::vector<float> mid_x;
+	std::vector<float> mid_y;
+	std::vector<float> length;
+	std::vector<float> x_min;
+	std::vector<float> x_max;
+
+	void clear();
+	void assign(const std::vector<LineF>& lines);
+	void push_back(const LineF& line);
+	size_t size() const;
+};
+
+// False for degenerate line
+bool normalizeLine(const LineF& line, float& a, float& b, float& c);
+
+// Distances from points to normalized line
+void pointLineDistances(float a, float b, float c, const PointBatch& points, std::vector<float>& distances);
+size_t countLineInliers(float a, float b, float c, float thresh, const PointBatch& points);
+
+// Appends intersections of line i with lines (i, size) lying outside of both segments x ranges and above y_max
+void intersectLines(const LineBatch& lines, size_t i, float y_max, PointBatch& intersections);
+
+// Sum of Rother weights of lines [begin, end) for candidate point.
+// Angle to the candidate is checked by cosine and computed from sine by series (ROTHER_MAX_ANG up to 30 degrees).
+double rotherWeights(const LineBatch& lines, size_t begin, size_t end, const cv::Point2f& point, double length_max);
+
+// Adds Rother weight of line i to the cells of cols x rows grid (row major votes, cell centers at origin + (c + 0.5) * cell_size)
+// whose centers lie in the line cone. Rows with center above y_max are skipped.
+// The cone is rasterized row by row, so the cost is O(rows + cells in the cone), not O(cells).
+// If best_cell is given (-1 for none), it is moved to a voted cell that gets more votes than it.
+void rotherVoteCells(const LineBatch& lines, size_t i, const cv::Point2d& origin, const cv::Point2d& cell_size, int cols, int rows,
+					 float y_max, double length_max, double* votes, int* best_cell = nullptr);
+
+// Buffers of fitLineRansac kept by caller between calls: no allocations once they have grown
+struct RansacWorkspace
+{
+	PointBatch points;
+	std::vector<float> distances;
+};
+
+bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result, const RansacParams& params, RansacWorkspace& workspace);
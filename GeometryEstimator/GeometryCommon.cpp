@@ -1,6 +1,20 @@
 #include "GeometryCommon.h"
+#include "GeometryBatch.h"
 
-bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result)
+// Number of points closer than thresh to line, false for degenerate line
+static bool lineInliers(double thresh, const LineF& line, const PointBatch& points, size_t& inliers_count)
+{
+	inliers_count = 0;
+
+	float a, b, c;
+	if (!normalizeLine(line, a, b, c))
+		return false;
+
+	inliers_count = countLineInliers(a, b, c, static_cast<float>(thresh), points);
+	return true;
+};
+
+static size_t fitLineExhaustive(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, const PointBatch& batch, LineF& line_result)
 {
 	size_t inliers_best = 0;
 
@@ -11,17 +25,9 @@ bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Poin
 			size_t inliers_count = 0;
 			const LineF line(*p1, *p2);
 
-			const float denominator = sqrt(line.A() * line.A() + line.B() * line.B());
-			if (abs(denominator) < FLT_EPSILON)
+			if (!lineInliers(thresh, line, batch, inliers_count))
 				continue;
 
-			for (size_t i = 0; i < points.size(); ++i)
-			{
-				const float rho = abs(line.A() * points[i].x + line.B() * points[i].y + line.C()) / denominator;
-				if (rho < thresh)
-					++inliers_count;
-			}
-
 			if (inliers_count < inliers_min)
 				continue;
 
@@ -33,62 +39,235 @@ bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Poin
 		}
 	}
 
-	if (inliers_best != 0)
-		return true;
-	else
-		return false;
+	return inliers_best;
 };
 
-void EstimateRotherVP(const std::vector<LineF> &lines, cv::Point2f &vpoint, cv::Point2i frame_size, bool ontop)
+static size_t fitLineRandomized(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, const PointBatch& batch, LineF& line_result, const RansacParams& params)
 {
-	if (lines.empty())
+	size_t inliers_best = 0;
+	size_t iterations = params.max_iterations;
+
+	std::mt19937 rng(params.seed);
+	std::uniform_int_distribution<size_t> index(0, points.size() - 1);
+
+	for (size_t it = 0; it < iterations; ++it)
 	{
-		return;
+		const size_t i = index(rng);
+		const size_t j = index(rng);
+		if (i == j)
+			continue;
+
+		size_t inliers_count = 0;
+		const LineF line(points[i], points[j]);
+
+		if (!lineInliers(thresh, line, batch, inliers_count))
+			continue;
+
+		if (inliers_count < inliers_min || inliers_count <= inliers_best)
+			continue;
+
+		inliers_best = inliers_count;
+		line_result = line;
+
+		// Samples needed to draw two inliers with given confidence
+		const double inliers_ratio = static_cast<double>(inliers_best) / points.size();
+		const double sample_fail = 1.0 - inliers_ratio * inliers_ratio;
+
+		if (sample_fail < DBL_EPSILON)
+			break;
+
+		const double needed = std::ceil(log(1.0 - params.confidence) / log(sample_fail));
+		if (needed < static_cast<double>(iterations))
+			iterations = static_cast<size_t>(needed);
 	}
 
+	return inliers_best;
+};
+
+// Least squares line through inliers, ends are projections of extreme inliers
+static void refineLine(double thresh, const PointBatch& points, std::vector<float>& distances, LineF& line)
+{
+	float a, b, c;
+	if (!normalizeLine(line, a, b, c))
+		return;
+
+	pointLineDistances(a, b, c, points, distances);
+
+	LineFitAccumulator fit;
+	for (size_t i = 0; i < points.size(); ++i)
+		if (distances[i] < thresh)
+			fit.add(points.point(i));
+
+	cv::Point2f center, direction;
+	if (!fit.line(center, direction))
+		return;
+
+	float t_min = FLT_MAX, t_max = -FLT_MAX;
+	for (size_t i = 0; i < points.size(); ++i)
+		if (distances[i] < thresh)
+		{
+			const float t = (points.point(i) - center).dot(direction);
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+
+	line = LineF(center + direction * t_min, center + direction * t_max);
+};
+
+bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result)
+{
+	return fitLineRansac(thresh, inliers_min, points, line_result, RansacParams());
+};
+
+bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result, const RansacParams& params)
+{
+	RansacWorkspace workspace;
+	return fitLineRansac(thresh, inliers_min, points, line_result, params, workspace);
+};
+
+bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result, const RansacParams& params, RansacWorkspace& workspace)
+{
+	if (points.size() < 2)
+		return false;
+
+	PointBatch& batch = workspace.points;
+	batch.assign(points);
+
+	const bool exhaustive = params.mode == RansacParams::Mode::exhaustive ||
+		(params.mode == RansacParams::Mode::automatic && points.size() <= RANSAC_EXHAUSTIVE_MAX_POINTS);
+
+	const size_t inliers_best = exhaustive ?
+		fitLineExhaustive(thresh, inliers_min, points, batch, line_result) :
+		fitLineRandomized(thresh, inliers_min, points, batch, line_result, params);
+
+	if (inliers_best == 0)
+		return false;
+
+	if (params.refine)
+		refineLine(thresh, batch, workspace.distances, line_result);
+
+	return true;
+};
+
+// False if there is no intersection with positive weight
+static bool EstimateRotherVPExact(const LineBatch &lines, double length_max, cv::Point2f &vpoint, cv::Point2i frame_size, bool ontop)
+{
 	double weight_max = 0.0;
 	cv::Point2f result_point = {};
-	std::vector<cv::Point2f> intersections;
 
-	// Compute lines intersection points
-	for (auto it_line_a = lines.begin(); it_line_a != lines.end(); it_line_a++)
+	// Compute lines intersection points lying outside of both segments:
+	// min(x1, x2) < x < max(x1, x2) means the point lies between ends of line segment
+	const float y_max = ontop ? static_cast<float>(frame_size.y) / 2.0f : FLT_MAX;
+
+	PointBatch intersections;
+	for (size_t i = 0; i < lines.size(); ++i)
+		intersectLines(lines, i, y_max, intersections);
+
+	// Find vanishing point
+	for (size_t i = 0; i < intersections.size(); ++i)
 	{
-		for (auto it_line_b = std::next(it_line_a); it_line_b != lines.end(); it_line_b++)
+		const cv::Point2f point = intersections.point(i);
+		const double weight = rotherWeights(lines, 0, lines.size(), point, length_max);
+
+		if (weight > weight_max)
 		{
-			float d = (it_line_a->A() * it_line_b->B()) - (it_line_a->B() * it_line_b->A());
+			weight_max = weight;
+			result_point = point;
+		}
+	}
 
-			if (abs(d) < FLT_EPSILON)
-			{
-				continue;
-			}
+	vpoint = result_point;
+	return weight_max > 0.0;
+};
 
-			cv::Point2f point{ -((it_line_a->C() * it_line_b->B()) - (it_line_a->B() * it_line_b->C())) / d ,
-				-((it_line_a->A() * it_line_b->C()) - (it_line_a->C() * it_line_b->A())) / d };
+// Votes of all lines for centers of cells x cells grid over region: every line adds its weight to the cells of its cone.
+// Lines are split between threads, each with its own accumulator: O(L * (rows + cone cells)) per region
+static void VoteRotherGrid(const LineBatch &lines, double length_max, const cv::Rect2d &region, float y_max, std::vector<double> &votes)
+{
+	const int cells = ROTHER_GRID_CELLS;
+	const cv::Point2d origin(region.x, region.y);
+	const cv::Point2d cell_size(region.width / cells, region.height / cells);
+	const int chunks = static_cast<int>(std::min<size_t>(lines.size(), std::max(cv::getNumThreads(), 1)));
 
-			// Does intersection point lie on either of two vanishing lines ?
-			// To answer this quiestion we should to check two conditions:
-			// 1) (x-x1)(y2-y1) - (y-y1)(x2-x1) = 0; the point lies on line. In our case this condition is always true.
-			// 2) min(x1, x2) < x < max(x1, x2); the point lies between ends of line segment.
-			const bool line_a_btw = (point.x > std::min(it_line_a->p1.x, it_line_a->p2.x)) && (point.x < std::max(it_line_a->p1.x, it_line_a->p2.x));
-			const bool line_b_btw = (point.x > std::min(it_line_b->p1.x, it_line_b->p2.x)) && (point.x < std::max(it_line_b->p1.x, it_line_b->p2.x));
+	std::vector<std::vector<double>> chunk_votes(chunks, std::vector<double>(cells * cells, 0.0));
 
-			if (!line_a_btw && !line_b_btw)
+	cv::parallel_for_(cv::Range(0, chunks), [&](const cv::Range& range)
+	{
+		for (int chunk = range.start; chunk < range.end; ++chunk)
+		{
+			std::vector<double>& chunk_vote = chunk_votes[chunk];
+			const size_t begin = lines.size() * chunk / chunks;
+			const size_t end = lines.size() * (chunk + 1) / chunks;
+
+			// Every line is weighted as in exact search
+			for (size_t i = begin; i < end; ++i)
+				rotherVoteCells(lines, i, origin, cell_size, cells, cells, y_max, length_max, chunk_vote.data());
+		}
+	});
+
+	votes.assign(cells * cells, 0.0);
+	for (const auto& chunk_vote : chunk_votes)
+		for (size_t i = 0; i < votes.size(); ++i)
+			votes[i] += chunk_vote[i];
+};
+
+static void EstimateRotherVPGrid(const LineBatch &lines, const LineBatch &sample, double length_max, cv::Point2f &vpoint, cv::Point2i frame_size, bool ontop)
+{
+	const float y_max = ontop ? static_cast<float>(frame_size.y) / 2.0f : FLT_MAX;
+	const double region_width = (1.0 + 2.0 * ROTHER_GRID_MARGIN) * frame_size.x;
+	const double region_height = (1.0 + 2.0 * ROTHER_GRID_MARGIN) * frame_size.y;
+
+	// Coarse level: frame with margins and the same area around VP of sampled lines
+	std::vector<cv::Rect2d> regions(1, cv::Rect2d(-ROTHER_GRID_MARGIN * frame_size.x, -ROTHER_GRID_MARGIN * frame_size.y, region_width, region_height));
+
+	cv::Point2f seed;
+	if (EstimateRotherVPExact(sample, length_max, seed, frame_size, ontop) && !regions[0].contains(cv::Point2d(seed.x, seed.y)))
+		regions.push_back(cv::Rect2d(seed.x - region_width / 2.0, seed.y - region_height / 2.0, region_width, region_height));
+
+	std::vector<double> votes;
+	cv::Point2f result_point = {};
+
+	for (int level = 0; level < ROTHER_GRID_LEVELS; ++level)
+	{
+		// Peak over all regions of the level
+		double vote_best = 0.0;
+		int best = -1;
+		cv::Rect2d region;
+
+		for (const auto& candidate : regions)
+		{
+			VoteRotherGrid(lines, length_max, candidate, y_max, votes);
+
+			const auto it_best = std::max_element(votes.begin(), votes.end());
+			if (*it_best > vote_best)
 			{
-				const float frame_center_y = static_cast<float>(frame_size.y) / 2.0f;
-
-				if (ontop)
-				{
-					if (point.y < frame_center_y)
-					{
-						intersections.push_back(point);
-					}
-				}
-				else
-				{
-					intersections.push_back(point);
-				}
+				vote_best = *it_best;
+				best = static_cast<int>(it_best - votes.begin());
+				region = candidate;
 			}
 		}
+
+		if (best < 0)
+			break;
+
+		const double cell_width = region.width / ROTHER_GRID_CELLS;
+		const double cell_height = region.height / ROTHER_GRID_CELLS;
+
+		result_point = cv::Point2f(static_cast<float>(region.x + (best % ROTHER_GRID_CELLS + 0.5) * cell_width),
+								   static_cast<float>(region.y + (best / ROTHER_GRID_CELLS + 0.5) * cell_height));
+
+		// Next level: 3x3 cells around the peak
+		regions.assign(1, cv::Rect2d(result_point.x - 1.5 * cell_width, result_point.y - 1.5 * cell_height, 3.0 * cell_width, 3.0 * cell_height));
+	}
+
+	vpoint = result_point;
+};
+
+void EstimateRotherVP(const std::vector<LineF> &lines, cv::Point2f &vpoint, cv::Point2i frame_size, bool ontop)
+{
+	if (lines.empty())
+	{
+		return;
 	}
 
 	// Find max length of lines
@@ -104,46 +283,104 @@ void EstimateRotherVP(const std::vector<LineF> &lines, cv::Point2f &vpoint, cv::
 		return;
 	}
 
-	// Find vanishing point
-	for (auto &point : intersections)
+	LineBatch batch;
+	batch.assign(lines);
+
+	if (lines.size() <= ROTHER_EXACT_MAX_LINES)
 	{
-		double weight = 0.0;
-		for (auto &line : lines)
-		{
-			cv::Point2f midPoint;
-			midPoint.x = (line.p1.x + line.p2.x) / 2.0f;
-			midPoint.y = (line.p1.y + line.p2.y) / 2.0f;
+		EstimateRotherVPExact(batch, length_max, vpoint, frame_size, ontop);
+		return;
+	}
 
-			LineF lineToVp(midPoint, point);
+	// Lines for the seed of grid search: partial shuffle with fixed seed, so result is repeatable
+	std::vector<size_t> indices(lines.size());
+	std::iota(indices.begin(), indices.end(), 0);
+	std::mt19937 rng(0);
 
-			double ch = line.A() * lineToVp.A() + line.B() * lineToVp.B();
-			double zn = sqrt(lineToVp.A() * lineToVp.A() + lineToVp.B() * lineToVp.B()) * sqrt(line.A() * line.A() + line.B() * line.B());
+	LineBatch sample;
+	for (size_t i = 0; i < ROTHER_EXACT_MAX_LINES; ++i)
+	{
+		std::swap(indices[i], indices[std::uniform_int_distribution<size_t>(i, indices.size() - 1)(rng)]);
+		sample.push_back(lines[indices[i]]);
+	}
 
-			if (abs(zn) < DBL_EPSILON)
-			{
-				continue;
-			}
+	EstimateRotherVPGrid(batch, sample, length_max, vpoint, frame_size, ontop);
+};
 
-			double dangle = abs(acos(ch / zn)) * DEGRAD;
+void LineFitAccumulator::clear()
+{
+	m_origin = {};
+	m_n = m_sx = m_sy = 0.0;
+	m_sxx = m_sxy = m_syy = 0.0;
+};
 
-			if (dangle > 90.0)
-			{
-				dangle = 180.0 - dangle;
-			}
+void LineFitAccumulator::add(const cv::Point2f& point)
+{
+	if (m_n == 0.0)
+		m_origin = cv::Point2d(point.x, point.y);
 
-			if (dangle < ROTHER_MAX_ANG)
-			{
-				double w = ROTHER_COEF_ANG * (1.0 - (dangle / ROTHER_MAX_ANG)) + ROTHER_COEF_LEN * (line.length() / length_max);
-				weight = weight + w;
-			}
-		}
+	const double x = point.x - m_origin.x;
+	const double y = point.y - m_origin.y;
 
-		if (weight > weight_max)
-		{
-			weight_max = weight;
-			result_point = point;
-		}
-	}
+	m_n += 1.0;
+	m_sx += x;
+	m_sy += y;
+	m_sxx += x * x;
+	m_sxy += x * y;
+	m_syy += y * y;
+};
 
-	vpoint = result_point;
-};
\ No newline at end of file
+size_t LineFitAccumulator::count() const
+{
+	return static_cast<size_t>(m_n);
+};
+
+void LineFitAccumulator::moments(double& mx, double& my, double& cxx, double& cxy, double& cyy) const
+{
+	mx = m_sx / m_n;
+	my = m_sy / m_n;
+	cxx = m_sxx / m_n - mx * mx;
+	cxy = m_sxy / m_n - mx * my;
+	cyy = m_syy / m_n - my * my;
+};
+
+bool LineFitAccumulator::line(cv::Point2f& center, cv::Point2f& direction) const
+{
+	if (m_n < 2.0)
+		return false;
+
+	double mx, my, cxx, cxy, cyy;
+	moments(mx, my, cxx, cxy, cyy);
+
+	// Principal axis of points covariance
+	if (cxx + cyy < DBL_EPSILON)
+		return false;
+
+	const double angle = 0.5 * atan2(2.0 * cxy, cxx - cyy);
+	center = cv::Point2f(static_cast<float>(mx + m_origin.x), static_cast<float>(my + m_origin.y));
+	direction = cv::Point2f(static_cast<float>(cos(angle)), static_cast<float>(sin(angle)));
+	return true;
+};
+
+double LineFitAccumulator::distance(const cv::Point2f& point) const
+{
+	cv::Point2f center, direction;
+	if (!line(center, direction))
+		return 0.0;
+
+	const cv::Point2f delta = point - center;
+	return abs(delta.x * direction.y - delta.y * direction.x);
+};
+
+double LineFitAccumulator::mean_squared_residual() const
+{
+	if (m_n < 2.0)
+		return 0.0;
+
+	double mx, my, cxx, cxy, cyy;
+	moments(mx, my, cxx, cxy, cyy);
+
+	// Smallest eigenvalue of covariance
+	const double half_diff = 0.5 * (cxx - cyy);
+	return std::max(0.0, 0.5 * (cxx + cyy) - sqrt(half_diff * half_diff + cxy * cxy));
+};
@@ -1,4 +1,7 @@
 #pragma once
+#include <random>
+#include <numeric>
+
 #include "opencv2/imgproc.hpp"
 
 #define DEGRAD  57.295779513082320876798154814105
@@ -7,6 +10,12 @@
 #define ROTHER_COEF_LEN 0.8
 #define ROTHER_COEF_ANG 0.2
 
+// Above this number of lines vanishing point is searched on a voting grid
+#define ROTHER_EXACT_MAX_LINES 100
+#define ROTHER_GRID_CELLS 64
+#define ROTHER_GRID_LEVELS 3
+#define ROTHER_GRID_MARGIN 0.5
+
 template <typename T>
 struct Line_
 {
@@ -39,5 +48,60 @@ typedef Line_<int> Line;
 typedef Line_<float> LineF;
 typedef Line_<double> LineD;
 
+// Running total least squares line fit: O(1) per point.
+// Sums are kept relative to the first point for numerical stability.
+class LineFitAccumulator
+{
+private:
+	cv::Point2d m_origin;
+	double m_n = 0.0;
+	double m_sx = 0.0, m_sy = 0.0;
+	double m_sxx = 0.0, m_sxy = 0.0, m_syy = 0.0;
+
+public:
+	void clear();
+	void add(const cv::Point2f& point);
+	size_t count() const;
+
+	// False if points don't define a direction yet
+	bool line(cv::Point2f& center, cv::Point2f& direction) const;
+	double distance(const cv::Point2f& point) const;
+	double mean_squared_residual() const;
+
+private:
+	void moments(double& mx, double& my, double& cxx, double& cxy, double& cyy) const;
+};
+
+#define RANSAC_EXHAUSTIVE_MAX_POINTS 16
+#define RANSAC_CONFIDENCE 0.99
+#define RANSAC_MAX_ITERATIONS 1000
+
+struct RansacParams
+{
+	// Automatic: exhaustive for up to RANSAC_EXHAUSTIVE_MAX_POINTS points, randomized otherwise
+	enum class Mode
+	{
+		automatic,
+		exhaustive,
+		randomized
+	};
+
+	Mode mode = Mode::automatic;
+	// Same seed gives same samples
+	unsigned int seed = 0;
+	// Number of samples adapts to the best inliers ratio found so far
+	double confidence = RANSAC_CONFIDENCE;
+	size_t max_iterations = RANSAC_MAX_ITERATIONS;
+	// Least squares fit to inliers of the best hypothesis
+	bool refine = true;
+};
+
 bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result);
+bool fitLineRansac(double thresh, size_t inliers_min, const std::vector<cv::Point2f>& points, LineF& line_result, const RansacParams& params);
+// Exact search over all intersections for few lines: O(L^3).
+// For many lines: coarse-to-fine grid, every line adds its weight to the cells of its cone (lines are split between threads),
+// then the grid is rebuilt around the peak: O(L * (rows + cone cells)) per grid. Coarse grids cover the frame extended by ROTHER_GRID_MARGIN
+// and, if it is outside, the same area around the exact VP of ROTHER_EXACT_MAX_LINES randomly sampled lines,
+// so far vanishing points are not clipped to the frame.
+// Both searches weight a candidate by all lines.
 void EstimateRotherVP(const std::vector<LineF> &lines, cv::Point2f &vpoint, cv::Point2i frame_size, bool ontop);
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "LPAssociation.h"
+
+LPAssociation::LPAssociation()
+{
+	m_solver = Solver::lapjv;
+	clear();
+};
+
+LPAssociation::Solver LPAssociation::solver() const
+{
+	return m_solver;
+};
+
+void LPAssociation::set_solver(Solver solver)
+{
+	m_solver = solver;
+};
+
+void LPAssociation::clear()
+{
+	m_cell_size = 1;
+	m_tracks_count = 0;
+	m_grid.clear();
+	m_candidates.clear();
+	m_plates_centers.clear();
+};
+
+long long LPAssociation::cell_key(int cx, int cy) const
+{
+	return (static_cast<long long>(cy) << 32) | static_cast<unsigned int>(cx);
+};
+
+void LPAssociation::init(size_t tracks_count, const std::vector<cv::Point>& plates_centers, int cell_size)
+{
+	m_tracks_count = tracks_count;
+	m_cell_size = std::max(1, cell_size);
+	m_plates_centers.assign(plates_centers.begin(), plates_centers.end());
+	m_candidates.clear();
+
+	// Put plates to grid
+	m_grid.resize(m_plates_centers.size());
+
+	for (size_t i = 0; i < m_plates_centers.size(); ++i)
+	{
+		const int cx = cvFloor(static_cast<double>(m_plates_centers[i].x) / m_cell_size);
+		const int cy = cvFloor(static_cast<double>(m_plates_centers[i].y) / m_cell_size);
+		m_grid[i] = std::make_pair(cell_key(cx, cy), i);
+	}
+
+	std::sort(m_grid.begin(), m_grid.end());
+};
+
+void LPAssociation::find_plates(const cv::Point2f& center, double radius, std::vector<size_t>& plates) const
+{
+	plates.clear();
+
+	const int cx_min = cvFloor((center.x - radius) / m_cell_size);
+	const int cx_max = cvFloor((center.x + radius) / m_cell_size);
+	const int cy_min = cvFloor((center.y - radius) / m_cell_size);
+	const int cy_max = cvFloor((center.y + radius) / m_cell_size);
+
+	for (int cy = cy_min; cy <= cy_max; ++cy)
+		for (int cx = cx_min; cx <= cx_max; ++cx)
+		{
+			const auto key = cell_key(cx, cy);
+			auto it = std::lower_bound(m_grid.begin(), m_grid.end(), std::make_pair(key, size_t(0)));
+
+			for (; it != m_grid.end() && it->first == key; ++it)
+				if (cv::norm(cv::Point2f(m_plates_centers[it->second]) - center) <= radius)
+					plates.push_back(it->second);
+		}
+};
+
+void LPAssociation::add_candidate(size_t track, size_t plate, double weight)
+{
+	assert(track < m_tracks_count && plate < m_plates_centers.size());
+
+	Candidate candidate;
+	candidate.track = track;
+	candidate.plate = plate;
+	candidate.weight = weight;
+	m_candidates.push_back(candidate);
+};
+
+size_t LPAssociation::find_root(size_t node)
+{
+	while (m_parent[node] != node)
+	{
+		m_parent[node] = m_parent[m_parent[node]];
+		node = m_parent[node];
+	}
+
+	return node;
+};
+
+void LPAssociation::unite(size_t node_a, size_t node_b)
+{
+	const size_t root_a = find_root(node_a);
+	const size_t root_b = find_root(node_b);
+
+	if (root_a != root_b)
+		m_parent[root_b] = root_a;
+};
+
+void LPAssociation::solve(std::vector<int>& track_plates)
+{
+	track_plates.assign(m_tracks_count, -1);
+
+	if (m_candidates.empty())
+		return;
+
+	// Nodes: tracks are [0, tracks_count), plates are [tracks_count, tracks_count + plates_count)
+	m_parent.resize(m_tracks_count + m_plates_centers.size());
+	for (size_t i = 0; i < m_parent.size(); ++i)
+		m_parent[i] = i;
+
+	for (const auto& c : m_candidates)
+		unite(c.track, m_tracks_count + c.plate);
+
+	for (auto& c : m_candidates)
+		c.component = find_root(c.track);
+
+	std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& a, const Candidate& b)
+	{
+		return a.component < b.component;
+	});
+
+	m_track_local.assign(m_tracks_count, -1);
+	m_plate_local.assign(m_plates_centers.size(), -1);
+
+	for (auto begin = m_candidates.cbegin(); begin != m_candidates.cend(); )
+	{
+		auto end = begin;
+		while (end != m_candidates.cend() && end->component == begin->component)
+			++end;
+
+		solve_component(begin, end, track_plates);
+		begin = end;
+	}
+};
+
+void LPAssociation::solve_component(std::vector<Candidate>::const_iterator begin, std::vector<Candidate>::const_iterator end, std::vector<int>& track_plates)
+{
+	// Single pair
+	if (std::next(begin) == end)
+	{
+		track_plates[begin->track] = static_cast<int>(begin->plate);
+		return;
+	}
+
+	m_component_tracks.clear();
+	m_component_plates.clear();
+
+	for (auto it = begin; it != end; ++it)
+	{
+		if (m_track_local[it->track] < 0)
+		{
+			m_track_local[it->track] = static_cast<int>(m_component_tracks.size());
+			m_component_tracks.push_back(it->track);
+		}
+
+		if (m_plate_local[it->plate] < 0)
+		{
+			m_plate_local[it->plate] = static_cast<int>(m_component_plates.size());
+			m_component_plates.push_back(it->plate);
+		}
+	}
+
+	// One track or one plate: the best pair is the optimal assignment
+	if (m_component_tracks.size() == 1 || m_component_plates.size() == 1)
+	{
+		auto best = std::min_element(begin, end, [](const Candidate& a, const Candidate& b)
+		{
+			return a.weight < b.weight;
+		});
+
+		track_plates[best->track] = static_cast<int>(best->plate);
+	}
+	else
+	{
+		const size_t rows = m_component_tracks.size();
+		const size_t cols = m_component_plates.size();
+
+		m_table.assign(rows * cols, ASSOCIATION_NO_EDGE_WEIGHT);
+		m_row_assignment.resize(rows);
+
+		for (auto it = begin; it != end; ++it)
+			m_table[m_track_local[it->track] * cols + m_plate_local[it->plate]] = it->weight;
+
+		if (m_solver == Solver::lapjv)
+			m_lapjv.solve(m_table.data(), rows, cols, m_row_assignment.data());
+		else
+			m_munkres.solve(m_table.data(), rows, cols, m_row_assignment.data());
+
+		for (size_t i = 0; i < rows; ++i)
+		{
+			const int j = m_row_assignment[i];
+			if (j >= 0 && m_table[i * cols + j] < ASSOCIATION_NO_EDGE_WEIGHT)
+				track_plates[m_component_tracks[i]] = static_cast<int>(m_component_plates[j]);
+		}
+	}
+
+	// Reset local indices for next component
+	for (auto track : m_component_tracks)
+		m_track_local[track] = -1;
+
+	for (auto plate : m_component_plates)
+		m_plate_local[plate] = -1;
+};
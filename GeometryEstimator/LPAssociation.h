@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "opencv2/imgproc.hpp"
+
+#include "munkres.h"
+#include "LapJV.h"
+
+#define ASSOCIATION_NO_EDGE_WEIGHT 100.0
+
+// Sparse track <-> plate assignment.
+// Only gated candidate pairs are stored. Pairs are split into connected components
+// and every component is solved separately: trivial ones greedily, others by Munkres.
+
+class LPAssociation
+{
+public:
+	enum class Solver
+	{
+		munkres,
+		lapjv
+	};
+
+private:
+	struct Candidate
+	{
+		size_t track = 0;
+		size_t plate = 0;
+		size_t component = 0;
+		double weight = 0.0;
+	};
+
+	// Spatial grid of plates centers: (cell key, plate index) sorted by key
+	int m_cell_size;
+	std::vector<cv::Point> m_plates_centers;
+	std::vector<std::pair<long long, size_t>> m_grid;
+
+	// Candidate pairs
+	size_t m_tracks_count;
+	std::vector<Candidate> m_candidates;
+
+	// Connected components
+	std::vector<size_t> m_parent;
+	std::vector<int> m_track_local;
+	std::vector<int> m_plate_local;
+	std::vector<size_t> m_component_tracks;
+	std::vector<size_t> m_component_plates;
+
+	// Dense solvers and their row major cost table
+	Solver m_solver;
+	LapJV<double> m_lapjv;
+	Munkres<double> m_munkres;
+	std::vector<double> m_table;
+	std::vector<int> m_row_assignment;
+
+public:
+	LPAssociation();
+	~LPAssociation() = default;
+
+	void clear();
+	Solver solver() const;
+	void set_solver(Solver solver);
+	void init(size_t tracks_count, const std::vector<cv::Point>& plates_centers, int cell_size);
+	void find_plates(const cv::Point2f& center, double radius, std::vector<size_t>& plates) const;
+	void add_candidate(size_t track, size_t plate, double weight);
+	void solve(std::vector<int>& track_plates);
+
+private:
+	long long cell_key(int cx, int cy) const;
+	size_t find_root(size_t node);
+	void unite(size_t node_a, size_t node_b);
+	void solve_component(std::vector<Candidate>::const_iterator begin, std::vector<Candidate>::const_iterator end, std::vector<int>& track_plates);
+};
@@ -0,0 +1,155 @@
+#include "LPCropAllocator.h"
+
+LPCropAllocator::LPCropAllocator()
+{
+	// Block sizes are multiples of 64 bytes to keep crops aligned inside slabs
+	const size_t block_sizes[] = { 512, 1024, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768, 49152, 65536 };
+
+	for (auto block_size : block_sizes)
+	{
+		SizeClass size_class;
+		size_class.block_size = block_size;
+		m_classes.push_back(size_class);
+	}
+
+	m_used_bytes = 0;
+};
+
+LPCropAllocator::~LPCropAllocator()
+{
+	for (auto slab : m_slabs)
+		cv::fastFree(slab);
+};
+
+LPCropAllocator* LPCropAllocator::instance()
+{
+	// Never destroyed: crops may outlive any static object that holds tracks
+	static LPCropAllocator* allocator = new LPCropAllocator();
+	return allocator;
+};
+
+cv::Mat LPCropAllocator::copy_crop(const cv::Mat& frame, const cv::Rect& rect)
+{
+	cv::Mat crop;
+	crop.allocator = instance();
+
+	const cv::Rect roi = rect & cv::Rect(0, 0, frame.cols, frame.rows);
+	if (!roi.empty())
+		frame(roi).copyTo(crop);
+
+	return crop;
+};
+
+size_t LPCropAllocator::used_bytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_used_bytes;
+};
+
+size_t LPCropAllocator::reserved_bytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_slabs.size() * CROP_SLAB_SIZE;
+};
+
+int LPCropAllocator::size_class(size_t size) const
+{
+	for (size_t i = 0; i < m_classes.size(); ++i)
+		if (size <= m_classes[i].block_size)
+			return static_cast<int>(i);
+
+	return -1;
+};
+
+cv::UMatData* LPCropAllocator::allocate(int dims, const int* sizes, int type, void* data0, size_t* step, int /*flags*/, cv::UMatUsageFlags /*usage_flags*/) const
+{
+	size_t total = CV_ELEM_SIZE(type);
+
+	for (int i = dims - 1; i >= 0; --i)
+	{
+		if (step)
+		{
+			if (data0 && step[i] != CV_AUTOSTEP)
+			{
+				CV_Assert(total <= step[i]);
+				total = step[i];
+			}
+			else
+			{
+				step[i] = total;
+			}
+		}
+
+		total *= sizes[i];
+	}
+
+	uchar* data = static_cast<uchar*>(data0);
+	const int class_id = size_class(total);
+
+	if (!data && class_id >= 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto& size_class = m_classes[class_id];
+
+		// Carve new slab into blocks
+		if (size_class.free_blocks.empty())
+		{
+			uchar* slab = static_cast<uchar*>(cv::fastMalloc(CROP_SLAB_SIZE));
+			m_slabs.push_back(slab);
+
+			for (size_t offset = 0; offset + size_class.block_size <= CROP_SLAB_SIZE; offset += size_class.block_size)
+				size_class.free_blocks.push_back(slab + offset);
+		}
+
+		data = size_class.free_blocks.back();
+		size_class.free_blocks.pop_back();
+		m_used_bytes += size_class.block_size;
+	}
+	else if (!data)
+	{
+		data = static_cast<uchar*>(cv::fastMalloc(total));
+	}
+
+	cv::UMatData* u = new cv::UMatData(this);
+	u->data = u->origdata = data;
+	u->size = total;
+
+	if (data0)
+		u->flags |= cv::UMatData::USER_ALLOCATED;
+
+	return u;
+};
+
+bool LPCropAllocator::allocate(cv::UMatData* data, int /*access_flags*/, cv::UMatUsageFlags /*usage_flags*/) const
+{
+	return data != nullptr;
+};
+
+void LPCropAllocator::deallocate(cv::UMatData* u) const
+{
+	if (!u)
+		return;
+
+	CV_Assert(u->urefcount == 0);
+	CV_Assert(u->refcount == 0);
+
+	if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+	{
+		const int class_id = size_class(u->size);
+
+		if (class_id >= 0)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_classes[class_id].free_blocks.push_back(u->origdata);
+			m_used_bytes -= m_classes[class_id].block_size;
+		}
+		else
+		{
+			cv::fastFree(u->origdata);
+		}
+
+		u->origdata = 0;
+	}
+
+	delete u;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#define CROP_SLAB_SIZE (256 * 1024)
+
+// Pooled allocator for plate crops.
+// Crops are copied out of the frame into fixed size blocks carved from big slabs,
+// so stored plates never keep the whole frame alive and freed blocks are reused.
+// Crops bigger than the largest block fall back to cv::fastMalloc.
+
+class LPCropAllocator : public cv::MatAllocator
+{
+private:
+	struct SizeClass
+	{
+		size_t block_size = 0;
+		std::vector<uchar*> free_blocks;
+	};
+
+	mutable std::mutex m_mutex;
+	mutable std::vector<SizeClass> m_classes;
+	mutable std::vector<uchar*> m_slabs;
+	mutable size_t m_used_bytes;
+
+public:
+	LPCropAllocator();
+	~LPCropAllocator();
+
+	static LPCropAllocator* instance();
+	static cv::Mat copy_crop(const cv::Mat& frame, const cv::Rect& rect);
+
+	size_t used_bytes() const;
+	size_t reserved_bytes() const;
+
+	cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, cv::UMatUsageFlags usage_flags) const override;
+	bool allocate(cv::UMatData* data, int access_flags, cv::UMatUsageFlags usage_flags) const override;
+	void deallocate(cv::UMatData* data) const override;
+
+private:
+	int size_class(size_t size) const;
+};
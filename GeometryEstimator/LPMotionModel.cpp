@@ -0,0 +1,51 @@
+#include "LPMotionModel.h"
+
+LPMotionModel::LPMotionModel()
+{
+	m_kalman.init(4, 2, 0, CV_32F);
+
+	m_kalman.transitionMatrix = (cv::Mat_<float>(4, 4) <<
+		1, 0, 1, 0,
+		0, 1, 0, 1,
+		0, 0, 1, 0,
+		0, 0, 0, 1);
+
+	cv::setIdentity(m_kalman.measurementMatrix);
+	cv::setIdentity(m_kalman.measurementNoiseCov, cv::Scalar::all(KALMAN_MEASUREMENT_NOISE));
+
+	m_kalman.processNoiseCov = cv::Mat::zeros(4, 4, CV_32F);
+	m_kalman.processNoiseCov.at<float>(0, 0) = KALMAN_PROCESS_NOISE_POS;
+	m_kalman.processNoiseCov.at<float>(1, 1) = KALMAN_PROCESS_NOISE_POS;
+	m_kalman.processNoiseCov.at<float>(2, 2) = KALMAN_PROCESS_NOISE_VEL;
+	m_kalman.processNoiseCov.at<float>(3, 3) = KALMAN_PROCESS_NOISE_VEL;
+};
+
+void LPMotionModel::init(LPMotionState& motion, const cv::Point2f& position) const
+{
+	motion.state = cv::Matx41f(position.x, position.y, 0.0f, 0.0f);
+	motion.covariance = cv::Matx44f::diag(cv::Matx41f(KALMAN_INITIAL_POS_VAR, KALMAN_INITIAL_POS_VAR, KALMAN_INITIAL_VEL_VAR, KALMAN_INITIAL_VEL_VAR));
+};
+
+void LPMotionModel::predict(LPMotionState& motion)
+{
+	cv::Mat(4, 1, CV_32F, motion.state.val).copyTo(m_kalman.statePost);
+	cv::Mat(4, 4, CV_32F, motion.covariance.val).copyTo(m_kalman.errorCovPost);
+
+	m_kalman.predict();
+
+	motion.state = cv::Matx41f(m_kalman.statePre.ptr<float>());
+	motion.covariance = cv::Matx44f(m_kalman.errorCovPre.ptr<float>());
+};
+
+void LPMotionModel::correct(LPMotionState& motion, const cv::Point2f& position)
+{
+	// Motion state must be already predicted for current frame
+	cv::Mat(4, 1, CV_32F, motion.state.val).copyTo(m_kalman.statePre);
+	cv::Mat(4, 4, CV_32F, motion.covariance.val).copyTo(m_kalman.errorCovPre);
+
+	const cv::Matx21f measurement(position.x, position.y);
+	m_kalman.correct(cv::Mat(2, 1, CV_32F, const_cast<float*>(measurement.val)));
+
+	motion.state = cv::Matx41f(m_kalman.statePost.ptr<float>());
+	motion.covariance = cv::Matx44f(m_kalman.errorCovPost.ptr<float>());
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "opencv2/video/tracking.hpp"
+#include "opencv2/imgproc.hpp"
+
+#define KALMAN_PROCESS_NOISE_POS 1.0f
+#define KALMAN_PROCESS_NOISE_VEL 4.0f
+#define KALMAN_MEASUREMENT_NOISE 4.0f
+#define KALMAN_INITIAL_POS_VAR 4.0f
+#define KALMAN_INITIAL_VEL_VAR 400.0f
+
+// Constant velocity motion state of one track: (x, y, vx, vy) and its covariance.
+struct LPMotionState
+{
+	cv::Matx41f state = {};
+	cv::Matx44f covariance = {};
+};
+
+// Kalman filter shared by all tracks.
+// Track state is loaded into the filter, processed and stored back,
+// so tracks keep plain values and can be copied freely.
+class LPMotionModel
+{
+private:
+	cv::KalmanFilter m_kalman;
+
+public:
+	LPMotionModel();
+	~LPMotionModel() = default;
+
+	void init(LPMotionState& motion, const cv::Point2f& position) const;
+	void predict(LPMotionState& motion);
+	void correct(LPMotionState& motion, const cv::Point2f& position);
+};
@@ -0,0 +1,133 @@
+#include "LPPlateDetector.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cassert>
+#include <algorithm>
+
+bool LPPlateDetector::init(const std::string& filename, size_t copies_count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Must not be called while detections are running
+	assert(m_free_detectors.size() == m_detectors.size());
+
+	m_detectors.clear();
+	m_free_detectors.clear();
+	m_original_window_size = cv::Size();
+
+	for (size_t i = 0; i < std::max<size_t>(1, copies_count); ++i)
+	{
+		auto detector = std::make_unique<cv::CascadeClassifier>();
+		if (!detector->load(cv::String(filename)) || detector->getOriginalWindowSize().empty())
+		{
+			m_detectors.clear();
+			m_free_detectors.clear();
+			return false;
+		}
+
+		m_original_window_size = detector->getOriginalWindowSize();
+		m_free_detectors.push_back(detector.get());
+		m_detectors.push_back(std::move(detector));
+	}
+
+	return true;
+};
+
+bool LPPlateDetector::empty() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_detectors.empty();
+};
+
+size_t LPPlateDetector::copies_count() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_detectors.size();
+};
+
+cv::Size LPPlateDetector::original_window_size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_original_window_size;
+};
+
+cv::CascadeClassifier* LPPlateDetector::acquire() const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_detectors.empty())
+		return nullptr;
+
+	m_released.wait(lock, [this] { return !m_free_detectors.empty(); });
+
+	auto detector = m_free_detectors.back();
+	m_free_detectors.pop_back();
+	return detector;
+};
+
+void LPPlateDetector::release(cv::CascadeClassifier* detector) const
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_free_detectors.push_back(detector);
+	}
+
+	m_released.notify_one();
+};
+
+std::vector<cv::Rect> LPPlateDetector::detect(const cv::Mat& gray_frame, const cv::Rect& ROI, const cv::Size& plate_size, int min_neighbor) const
+{
+	if (plate_size.empty() || gray_frame.empty() || gray_frame.size().area() == 0)
+		return {};
+
+	cv::Rect roi(0, 0, gray_frame.cols, gray_frame.rows);
+	if (!ROI.empty() && !(ROI.x < roi.x || ROI.y < roi.y || ROI.x + ROI.width > roi.width || ROI.y + ROI.height > roi.height))
+		roi = ROI;
+	else
+		return {};
+
+	cv::CascadeClassifier* detector = acquire();
+	if (detector == nullptr)
+		return {};
+
+	std::vector<cv::Rect> plates;
+	const cv::Size orig_wnd = detector->getOriginalWindowSize();
+
+	const double k_rsz = sqrt(static_cast<double>(orig_wnd.area()) / plate_size.area());
+	if (abs(k_rsz) < DBL_EPSILON)
+	{
+		release(detector);
+		return {};
+	}
+	
+	if (k_rsz > 1.0) //(k_rsz - 1.0) >= -DBL_EPSILON
+	{
+		cv::Mat resized_frame;
+		cv::resize(gray_frame(roi), resized_frame, cv::Size(), k_rsz, k_rsz);
+
+		detector->detectMultiScale(resized_frame, plates, 1.1, min_neighbor, 0, orig_wnd, orig_wnd);
+
+		for (auto& plate : plates)
+		{
+			plate.x /= k_rsz;
+			plate.y /= k_rsz;
+			plate.width /= k_rsz;
+			plate.height /= k_rsz;
+		}
+	}
+	else
+	{
+		detector->detectMultiScale(gray_frame(roi), plates, 1.1, min_neighbor, 0, plate_size, plate_size);
+	}
+
+	release(detector);
+
+	for (auto& plate : plates)
+	{
+		plate.x += roi.x;
+		plate.y += roi.y;
+	}
+
+	return plates;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <condition_variable>
+
+#include "opencv2/objdetect.hpp"
+#include "opencv2/imgproc.hpp"
+
+// Cascade plate detector which can be shared between recognizers and threads.
+// CascadeClassifier is not thread safe, so the model is loaded into several copies:
+// every detection takes a free copy and waits if all copies are busy.
+
+class LPPlateDetector
+{
+private:
+	mutable std::mutex m_mutex;
+	mutable std::condition_variable m_released;
+	std::vector<std::unique_ptr<cv::CascadeClassifier>> m_detectors;
+	mutable std::vector<cv::CascadeClassifier*> m_free_detectors;
+	cv::Size m_original_window_size;
+
+public:
+	LPPlateDetector() = default;
+	~LPPlateDetector() = default;
+
+	bool init(const std::string& filename, size_t copies_count);
+	bool empty() const;
+	size_t copies_count() const;
+	cv::Size original_window_size() const;
+
+	std::vector<cv::Rect> detect(const cv::Mat& gray_frame, const cv::Rect& ROI, const cv::Size& plate_size, int min_neighbor) const;
+
+private:
+	cv::CascadeClassifier* acquire() const;
+	void release(cv::CascadeClassifier* detector) const;
+};
@@ -8,22 +8,35 @@ LPRecognizer::LPRecognizer()
 	m_is_calibration_finished.store(true);
 	m_calibration_interruption.store(false);
 
-	p_plate_detector = std::make_unique<cv::CascadeClassifier>();
+	m_is_new_image_detection = false;
+	m_is_new_image_calibration = false;
+
+	p_plate_detector = std::make_shared<LPPlateDetector>();
 }
 
 LPRecognizer::~LPRecognizer()
 {
 }
 
-bool LPRecognizer::init()
+bool LPRecognizer::init(size_t detectors_count)
 {
-	if (!p_plate_detector)
+	auto plate_detector = detector();
+	if (!plate_detector)
 		return false;
 
-	if (p_plate_detector->load(cv::String("haarcascade_russian_plate_number.xml")))
-		return true;
-	else
-		return false;
+	return plate_detector->init("haarcascade_russian_plate_number.xml", detectors_count);
+};
+
+std::shared_ptr<LPPlateDetector> LPRecognizer::detector() const
+{
+	std::lock_guard<std::mutex> lock(m_detector_mutex);
+	return p_plate_detector;
+};
+
+void LPRecognizer::set_detector(std::shared_ptr<LPPlateDetector> detector)
+{
+	std::lock_guard<std::mutex> lock(m_detector_mutex);
+	p_plate_detector = detector;
 };
 
 void LPRecognizer::set_min_plate_size(const cv::Size& size)
@@ -309,12 +322,36 @@ bool LPRecognizer::load_from_json(const std::string& filename)
 };
 
 bool LPRecognizer::capture_frame(const cv::Mat& frame)
+{
+	uint64_t sequence;
+	return capture_frame(frame, sequence);
+};
+
+bool LPRecognizer::capture_frame(const cv::Mat& frame, uint64_t& sequence)
 {
 	if (frame.empty() || frame.size().area() == 0)
 		return false;
 
+	sequence = m_ingest.next_sequence();
+
+	if (m_ingest.is_skipped(sequence))
+		return false;
+
 	m_input_mutex.lock();
 
+	// Single frame slot is full while none of consumers has taken the previous frame
+	if (m_is_new_image_detection && m_is_new_image_calibration)
+	{
+		if (!m_ingest.evicts_when_full())
+		{
+			m_ingest.count_rejected();
+			m_input_mutex.unlock();
+			return false;
+		}
+
+		m_ingest.count_evicted();
+	}
+
 	if (frame.type() != CV_8UC1)
 		cvtColor(frame, m_gray_image, cv::COLOR_BGR2GRAY);
 	else
@@ -326,6 +363,16 @@ bool LPRecognizer::capture_frame(const cv::Mat& frame)
 	return true;
 };
 
+void LPRecognizer::set_ingest_policy(FrameIngest::Policy policy, size_t nth)
+{
+	m_ingest.set_policy(policy, nth);
+};
+
+FrameIngest::Stats LPRecognizer::ingest_stats() const
+{
+	return m_ingest.stats();
+};
+
 bool LPRecognizer::is_calibration_finished() const
 {
 	return m_is_calibration_finished.load();
@@ -389,24 +436,19 @@ bool LPRecognizer::detect(std::vector<cv::Rect>& plates)
 	m_is_new_image_detection = false;
 	m_input_mutex.unlock();
 
+	return detect(img_working, plates);
+};
+
+bool LPRecognizer::detect(const cv::Mat& gray_frame, std::vector<cv::Rect>& plates) const
+{
 	// Detect plates
+	for (const auto& zone : detection_zones())
 	{
-		std::lock_guard<std::mutex> lock(m_zones_mutex);
-
-		for (auto it = m_zones.begin(); it != m_zones.end(); ++it)
-		{
-			if ((it->plate_size().area() < min_plate_size().area() && !min_plate_size().empty())|| 
-				(it->plate_size().area() > max_plate_size().area() && !max_plate_size().empty()))
-				continue;
-
-			std::vector<cv::Rect> plates_ = detect_plates(img_working, it->zone(), it->plate_size(), 3);
-			plates.insert(plates.end(), plates_.begin(), plates_.end());
-		}
+		std::vector<cv::Rect> plates_ = detect_zone(gray_frame, zone.first, zone.second);
+		plates.insert(plates.end(), plates_.begin(), plates_.end());
 	}
 
-	// Group idential rects
-	plates.insert(std::end(plates), std::begin(plates), std::end(plates));
-	cv::groupRectangles(plates, 1, 0.5);
+	group_plates(plates);
 
 	if (plates.empty())
 		return false;
@@ -414,55 +456,43 @@ bool LPRecognizer::detect(std::vector<cv::Rect>& plates)
 	return true;
 };
 
-std::vector<cv::Rect> LPRecognizer::detect_plates(const cv::Mat& gray_frame, const cv::Rect& ROI, const cv::Size& plate_size, const int& min_neighbor) const
+std::vector<std::pair<cv::Rect, cv::Size>> LPRecognizer::detection_zones() const
 {
-	std::lock_guard<std::mutex> lock(m_detector_mutex);
+	// Copy zones parameters, so detection doesn't hold zones lock
+	std::vector<std::pair<cv::Rect, cv::Size>> zones;
+	std::lock_guard<std::mutex> lock(m_zones_mutex);
 
-	if (!p_plate_detector || p_plate_detector->empty() || p_plate_detector->getOriginalWindowSize().empty())
-		return {};
-
-	if (plate_size.empty() || gray_frame.empty() || gray_frame.size().area() == 0)
-		return {};
-
-	cv::Rect roi(0, 0, gray_frame.cols, gray_frame.rows);
-	if (!ROI.empty() && !(ROI.x < roi.x || ROI.y < roi.y || ROI.x + ROI.width > roi.width || ROI.y + ROI.height > roi.height))
-		roi = ROI;
-	else
-		return {};
+	for (auto it = m_zones.begin(); it != m_zones.end(); ++it)
+	{
+		if ((it->plate_size().area() < min_plate_size().area() && !min_plate_size().empty())|| 
+			(it->plate_size().area() > max_plate_size().area() && !max_plate_size().empty()))
+			continue;
 
-	std::vector<cv::Rect> plates;
-	const cv::Size orig_wnd = p_plate_detector->getOriginalWindowSize();
+		zones.emplace_back(it->zone(), it->plate_size());
+	}
 
-	const double k_rsz = sqrt(static_cast<double>(orig_wnd.area()) / plate_size.area());
-	if (abs(k_rsz) < DBL_EPSILON) return {};
-	
-	if (k_rsz > 1.0) //(k_rsz - 1.0) >= -DBL_EPSILON
-	{
-		cv::Mat resized_frame;
-		cv::resize(gray_frame(roi), resized_frame, cv::Size(), k_rsz, k_rsz);
+	return zones;
+};
 
-		p_plate_detector->detectMultiScale(resized_frame, plates, 1.1, min_neighbor, 0, orig_wnd, orig_wnd);
+std::vector<cv::Rect> LPRecognizer::detect_zone(const cv::Mat& gray_frame, const cv::Rect& zone, const cv::Size& plate_size) const
+{
+	return detect_plates(gray_frame, zone, plate_size, 3);
+};
 
-		for (auto& plate : plates)
-		{
-			plate.x /= k_rsz;
-			plate.y /= k_rsz;
-			plate.width /= k_rsz;
-			plate.height /= k_rsz;
-		}
-	}
-	else
-	{
-		p_plate_detector->detectMultiScale(gray_frame(roi), plates, 1.1, min_neighbor, 0, plate_size, plate_size);
-	}
+void LPRecognizer::group_plates(std::vector<cv::Rect>& plates)
+{
+	// Group idential rects
+	plates.insert(std::end(plates), std::begin(plates), std::end(plates));
+	cv::groupRectangles(plates, 1, 0.5);
+};
 
-	for (auto& plate : plates)
-	{
-		plate.x += roi.x;
-		plate.y += roi.y;
-	}
+std::vector<cv::Rect> LPRecognizer::detect_plates(const cv::Mat& gray_frame, const cv::Rect& ROI, const cv::Size& plate_size, const int& min_neighbor) const
+{
+	auto plate_detector = detector();
+	if (!plate_detector)
+		return {};
 
-	return plates;
+	return plate_detector->detect(gray_frame, ROI, plate_size, min_neighbor);
 };
 
 void LPRecognizer::calibration_function()
@@ -578,7 +608,7 @@ void LPRecognizer::calibration_function()
 			// Compute initial plate size		
 			{
 				std::lock_guard<std::mutex> lock(m_detector_mutex);
-				orig_plate_size = p_plate_detector->getOriginalWindowSize();
+				orig_plate_size = p_plate_detector->original_window_size();
 			}
 
 			if (!min_ps.empty() && !max_ps.empty() && min_ps.area() < max_ps.area())
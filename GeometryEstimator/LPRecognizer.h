@@ -18,6 +18,8 @@
 #include "rapidjson/prettywriter.h"
 
 #include "LPRecognizerZone.h"
+#include "LPPlateDetector.h"
+#include "FrameIngest.h"
 
 #define DEBUG_PRINT
 #define POINTS_TO_CALIBRATE 75
@@ -35,9 +37,9 @@ private:
 	mutable std::mutex m_zones_mutex;
 	std::list<LPRecognizerZone> m_zones;
 
-	// Detector
+	// Detector (may be shared with other recognizers)
 	mutable std::mutex m_detector_mutex;
-	std::unique_ptr<cv::CascadeClassifier> p_plate_detector;
+	std::shared_ptr<LPPlateDetector> p_plate_detector;
 
 	// Plate sizes
 	cv::Size m_min_plate_size; 
@@ -49,6 +51,7 @@ private:
 	std::mutex m_input_mutex;
 	bool m_is_new_image_detection;
 	bool m_is_new_image_calibration;
+	FrameIngest m_ingest;
 
 	// Calibration
 	enum class CalibrationState
@@ -69,12 +72,24 @@ public:
 	LPRecognizer();
 	~LPRecognizer();
 
-	bool init();
+	bool init(size_t detectors_count = 1);
 	bool stop_calibration();
 	bool start_calibration();
 	bool is_calibration_finished() const;
 	bool capture_frame(const cv::Mat& frame);
+	bool capture_frame(const cv::Mat& frame, uint64_t& sequence);
+	void set_ingest_policy(FrameIngest::Policy policy, size_t nth = 1);
+	FrameIngest::Stats ingest_stats() const;
 	bool detect(std::vector<cv::Rect>& plates);
+	bool detect(const cv::Mat& gray_frame, std::vector<cv::Rect>& plates) const;
+
+	// Detection split by zones: zone rect and plate size of every zone to search in
+	std::vector<std::pair<cv::Rect, cv::Size>> detection_zones() const;
+	std::vector<cv::Rect> detect_zone(const cv::Mat& gray_frame, const cv::Rect& zone, const cv::Size& plate_size) const;
+	static void group_plates(std::vector<cv::Rect>& plates);
+
+	std::shared_ptr<LPPlateDetector> detector() const;
+	void set_detector(std::shared_ptr<LPPlateDetector> detector);
 
 	cv::Size min_plate_size() const;
 	cv::Size max_plate_size() const;
@@ -2,6 +2,7 @@
 
 LPTrack::LPTrack()
 {
+	m_state = State::tentative;
 	clean_lost_frames();
 };
 
@@ -9,22 +10,105 @@ LPTrack::~LPTrack()
 {
 };
 
+LPTrack::LPTrack(const cv::Rect& rect, const FrameTag& frame)
+{
+	m_state = State::tentative;
+	clean_lost_frames();
+	add_rect(rect, frame);
+};
+
 LPTrack::LPTrack(const LPPlate& plate)
 {
+	m_state = State::confirmed;
 	clean_lost_frames();
 	add_plate(plate);
 };
 
 LPTrack::LPTrack(const LPPlate& plate, cv::Scalar color)
 {
+	m_state = State::confirmed;
 	clean_lost_frames();
 	add_plate(plate);
 	set_color(color);
 }
 
-void LPTrack::add_plate(const LPPlate& plate)
+void LPTrack::add_plate(const LPPlate& plate, const FrameTag& frame)
+{
+	add_rect(*plate.get_rect(), frame);
+	add_crop(plate);
+};
+
+void LPTrack::add_rect(const cv::Rect& rect, const FrameTag& frame)
 {
-	m_plates.push_back(plate);
+	if (!m_trajectory.empty())
+		m_lenght += cv::norm(rect_center(rect) - rect_center(m_trajectory.back()));
+
+	m_trajectory.push_back(rect);
+	m_frames.push_back(frame);
+};
+
+void LPTrack::add_crop(const LPPlate& plate)
+{
+	// Keep the best crops only
+	const double score = crop_score(plate);
+
+	if (m_plates.size() < MAX_TRACK_CROPS)
+	{
+		m_plates.push_back(plate);
+		m_plates_scores.push_back(score);
+	}
+	else
+	{
+		auto it_worst = std::min_element(m_plates_scores.begin(), m_plates_scores.end());
+
+		if (score > *it_worst)
+		{
+			const auto worst = std::distance(m_plates_scores.begin(), it_worst);
+
+			// Shift to keep crops in time order
+			m_plates.erase(m_plates.begin() + worst);
+			m_plates_scores.erase(it_worst);
+			m_plates.push_back(plate);
+			m_plates_scores.push_back(score);
+		}
+	}
+};
+
+double LPTrack::crop_score(const LPPlate& plate)
+{
+	// Bigger and sharper crops are better: area * (variance of laplacian)
+	const double area = static_cast<double>(plate.get_rect()->area());
+	const cv::Mat* image = plate.get_image();
+
+	if (image == nullptr || image->empty())
+		return area;
+
+	cv::Mat laplacian;
+	cv::Scalar mean, stddev;
+	cv::Laplacian(*image, laplacian, CV_16S);
+	cv::meanStdDev(laplacian, mean, stddev);
+
+	return area * (1.0 + stddev[0] * stddev[0]);
+};
+
+cv::Point LPTrack::rect_center(const cv::Rect& rect)
+{
+	return cv::Point(rect.x + rect.width / 2, rect.y + rect.height / 2);
+};
+
+LPTrack::State LPTrack::state() const
+{
+	return m_state;
+};
+
+void LPTrack::set_state(State state)
+{
+	m_state = state;
+};
+
+bool LPTrack::is_confirmed() const
+{
+	return m_state == State::confirmed;
 };
 
 void LPTrack::inc_lost_frames()
@@ -57,40 +141,77 @@ const std::vector<LPPlate>* LPTrack::get_plates() const
 	return &m_plates;
 };
 
-int LPTrack::average_plate_width() const
+const LPPlate* LPTrack::best_plate() const
 {
-	int result = 0;
+	if (m_plates.empty())
+		return nullptr;
 
-	for (size_t i = 0; i < m_plates.size(); ++i)
-		result += m_plates[i].get_rect()->width;
+	const auto best = std::max_element(m_plates_scores.begin(), m_plates_scores.end());
+	return &m_plates[std::distance(m_plates_scores.begin(), best)];
+};
 
-	if (m_plates.size() != 0)
-		result /= m_plates.size();
-	
-	return result;
+const std::vector<cv::Rect>* LPTrack::get_trajectory() const
+{
+	return &m_trajectory;
+};
+
+const std::vector<FrameTag>* LPTrack::get_frames() const
+{
+	return &m_frames;
 };
 
-int LPTrack::average_plate_height() const
+FrameTag LPTrack::first_frame() const
 {
-	int result = 0;
+	if (m_frames.empty())
+		return {};
+
+	return m_frames.front();
+};
+
+FrameTag LPTrack::last_frame() const
+{
+	if (m_frames.empty())
+		return {};
+
+	return m_frames.back();
+};
 
-	for (size_t i = 0; i < m_plates.size(); ++i)
-		result += m_plates[i].get_rect()->height;
+cv::Rect LPTrack::last_rect() const
+{
+	if (m_trajectory.empty())
+		return {};
 
-	if (m_plates.size() != 0)
-		result /= m_plates.size();
+	return m_trajectory.back();
+};
 
-	return result;
+cv::Point LPTrack::end_point() const
+{
+	return rect_center(last_rect());
 };
 
 double LPTrack::lenght() const
 {
-	double result = 0.0;
+	return m_lenght;
+};
 
-	for (auto it = std::next(m_plates.begin()); it != m_plates.end(); ++it)
-		result += cv::norm(it->center_position() - std::prev(it)->center_position());
+LPMotionState& LPTrack::motion()
+{
+	return m_motion;
+};
 
-	return result;
+const LPMotionState& LPTrack::motion() const
+{
+	return m_motion;
+};
+
+cv::Point2f LPTrack::predicted_position() const
+{
+	return cv::Point2f(m_motion.state(0), m_motion.state(1));
+};
+
+double LPTrack::position_uncertainty() const
+{
+	return sqrt(std::max(m_motion.covariance(0, 0), m_motion.covariance(1, 1)));
 };
 
 int LPTrack::get_average_age() const
@@ -1,39 +1,91 @@
 #pragma once
+#include <vector>
+#include <algorithm>
+
 //#include "opencv2/video/tracking.hpp"
 #include "opencv2/imgproc.hpp"
 //#include "opencv2/videoio.hpp"
 //#include "opencv2/highgui.hpp"
 
 #include "LPPlate.h"
+#include "LPMotionModel.h"
+#include "FrameIngest.h"
+
+#define MAX_TRACK_CROPS 5
 
 class LPTrack
 {
+public:
+	// Tentative tracks keep rects only, crops are stored after confirmation
+	enum class State
+	{
+		tentative,
+		confirmed,
+		lost
+	};
+
 private:
+	State m_state;
+
+	// Full trajectory is kept as rects, plate crops only for the best MAX_TRACK_CROPS plates
+	std::vector<cv::Rect> m_trajectory;
+	std::vector<FrameTag> m_frames; // frame of every trajectory rect
 	std::vector<LPPlate> m_plates;
+	std::vector<double> m_plates_scores;
 	cv::Scalar m_color;
 	int m_lost_frames;
 
+	// Trajectory length (updated in add_rect)
+	double m_lenght = 0.0;
+
+	// Motion state (updated by LPMotionModel)
+	LPMotionState m_motion;
+
 public:
 	LPTrack();
+	LPTrack(const cv::Rect& rect, const FrameTag& frame = FrameTag());
 	LPTrack(const LPPlate& plate);
 	LPTrack(const LPPlate& plate, cv::Scalar color);
+	LPTrack(const LPTrack&) = default;
+	LPTrack(LPTrack&&) = default;
+	LPTrack& operator=(const LPTrack&) = default;
+	LPTrack& operator=(LPTrack&&) = default;
 	~LPTrack();
 
-	void add_plate(const LPPlate& plate);
+	void add_rect(const cv::Rect& rect, const FrameTag& frame = FrameTag());
+	void add_plate(const LPPlate& plate, const FrameTag& frame = FrameTag());
 	const std::vector<LPPlate>* get_plates() const;
+	const LPPlate* best_plate() const;
+	const std::vector<cv::Rect>* get_trajectory() const;
+	const std::vector<FrameTag>* get_frames() const;
+	FrameTag first_frame() const;
+	FrameTag last_frame() const;
+	cv::Rect last_rect() const;
+	cv::Point end_point() const;
 
 	int get_average_age() const;
 
+	State state() const;
+	void set_state(State state);
+	bool is_confirmed() const;
+
 	int lost_frames() const;
 	void inc_lost_frames();
 	void clean_lost_frames();
 
 	cv::Scalar color() const;
 	void set_color(cv::Scalar color);
-	
-	int average_plate_width() const;
-	int average_plate_height() const;
 
 	double lenght() const;
+
+	LPMotionState& motion();
+	const LPMotionState& motion() const;
+	cv::Point2f predicted_position() const;
+	double position_uncertainty() const;
+
+private:
+	static cv::Point rect_center(const cv::Rect& rect);
+	static double crop_score(const LPPlate& plate);
+	void add_crop(const LPPlate& plate);
 };
 
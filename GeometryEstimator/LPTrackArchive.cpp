@@ -0,0 +1,395 @@
+#include "LPTrackArchive.h"
+
+#include <limits>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	bool file_exists(const std::string& filename)
+	{
+		std::ifstream file(filename.c_str(), std::fstream::binary);
+		return file.is_open();
+	}
+
+	size_t align8(size_t size)
+	{
+		return (size + 7) & ~size_t(7);
+	}
+}
+
+// Writer
+
+LPTrackArchive::LPTrackArchive()
+{
+	m_segment_number = 0;
+	m_segment_size = 0;
+	m_block_records = 0;
+	m_block = LPArchiveIndexEntry();
+};
+
+LPTrackArchive::~LPTrackArchive()
+{
+	close();
+};
+
+std::string LPTrackArchive::segment_filename(const std::string& directory, uint32_t number)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "segment_%06u.lpa", number);
+	return directory + "/" + name;
+};
+
+std::string LPTrackArchive::index_filename(const std::string& directory, uint32_t number)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "segment_%06u.idx", number);
+	return directory + "/" + name;
+};
+
+bool LPTrackArchive::open(const std::string& directory)
+{
+	close();
+
+	m_directory = directory;
+	m_segment_number = 0;
+
+	while (file_exists(segment_filename(m_directory, m_segment_number)))
+		++m_segment_number;
+
+	// Continue ids after the last archived record
+	uint64_t first_id = 0;
+
+	if (m_segment_number > 0)
+	{
+		MappedFile last_segment;
+
+		if (last_segment.open(segment_filename(m_directory, m_segment_number - 1)) && last_segment.size() >= sizeof(LPArchiveSegmentHeader))
+		{
+			LPArchiveSegmentHeader header;
+			memcpy(&header, last_segment.data(), sizeof(header));
+			first_id = header.first_id;
+
+			LPTrackRecordView view;
+			size_t offset = sizeof(LPArchiveSegmentHeader);
+
+			while (LPTrackArchiveReader::parse_record(last_segment.data(), last_segment.size(), offset, view, offset))
+				first_id = view.id + 1;
+		}
+	}
+
+	if (!open_segment(first_id))
+		return false;
+
+	start(first_id);
+	return true;
+};
+
+void LPTrackArchive::close()
+{
+	stop();
+
+	if (m_segment.is_open())
+		close_segment();
+};
+
+bool LPTrackArchive::open_segment(uint64_t first_id)
+{
+	const uint32_t number = m_segment_number;
+
+	m_segment.open(segment_filename(m_directory, number).c_str(), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	m_index.open(index_filename(m_directory, number).c_str(), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+
+	if (!m_segment.is_open() || !m_index.is_open())
+	{
+		m_segment.close();
+		m_index.close();
+		return false;
+	}
+
+	// Number is taken only by opened segment, so a failed open can be retried
+	++m_segment_number;
+
+	LPArchiveSegmentHeader header;
+	header.magic = ARCHIVE_SEGMENT_MAGIC;
+	header.version = ARCHIVE_VERSION;
+	header.first_id = first_id;
+
+	m_segment.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_segment.flush();
+
+	m_segment_size = sizeof(header);
+	m_block_records = 0;
+	return true;
+};
+
+void LPTrackArchive::close_segment()
+{
+	flush();
+
+	if (m_block_records > 0)
+		write_block();
+
+	m_index.close();
+	m_segment.close();
+};
+
+void LPTrackArchive::write_block()
+{
+	m_index.write(reinterpret_cast<const char*>(&m_block), sizeof(m_block));
+	m_block_records = 0;
+};
+
+bool LPTrackArchive::write(uint64_t id, const LPTrack& track)
+{
+	const auto* trajectory = track.get_trajectory();
+	const LPPlate* best_plate = track.best_plate();
+	const cv::Mat* crop = best_plate != nullptr ? best_plate->get_image() : nullptr;
+	const bool has_crop = crop != nullptr && !crop->empty();
+
+	const size_t rects_size = trajectory->size() * 4 * sizeof(int32_t);
+	const size_t crop_size = has_crop ? crop->total() * crop->elemSize() : 0;
+	const size_t record_size = align8(sizeof(LPArchiveRecordHeader) + rects_size + crop_size);
+
+	// Start new segment if record doesn't fit
+	if (m_segment.is_open() && m_segment_size > sizeof(LPArchiveSegmentHeader) && m_segment_size + record_size > ARCHIVE_SEGMENT_SIZE)
+		close_segment();
+
+	// Segment failed to open is retried on every write, track is dropped until it opens
+	if (!m_segment.is_open() && !open_segment(id))
+		return false;
+
+	LPArchiveRecordHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = ARCHIVE_RECORD_MAGIC;
+	header.size = static_cast<uint32_t>(record_size);
+	header.id = id;
+	header.begin_time = FrameIngest::to_system_ms(track.first_frame().timestamp);
+	header.end_time = FrameIngest::to_system_ms(track.last_frame().timestamp);
+	header.rects_count = static_cast<uint32_t>(trajectory->size());
+
+	if (best_plate != nullptr)
+	{
+		const cv::Rect* rect = best_plate->get_rect();
+		header.crop_rect[0] = rect->x;
+		header.crop_rect[1] = rect->y;
+		header.crop_rect[2] = rect->width;
+		header.crop_rect[3] = rect->height;
+	}
+
+	if (has_crop)
+	{
+		header.crop_type = crop->type();
+		header.crop_rows = crop->rows;
+		header.crop_cols = crop->cols;
+	}
+
+	const size_t record_begin = m_buffer.size();
+	m_buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& rect : *trajectory)
+	{
+		const int32_t values[4] = { rect.x, rect.y, rect.width, rect.height };
+		m_buffer.append(reinterpret_cast<const char*>(values), sizeof(values));
+	}
+
+	if (has_crop)
+	{
+		const size_t row_size = crop->cols * crop->elemSize();
+		for (int r = 0; r < crop->rows; ++r)
+			m_buffer.append(reinterpret_cast<const char*>(crop->ptr(r)), row_size);
+	}
+
+	m_buffer.resize(record_begin + record_size, '\0');
+
+	// Sparse index
+	if (m_block_records == 0)
+	{
+		m_block.begin_offset = m_segment_size;
+		m_block.min_begin_time = std::numeric_limits<int64_t>::max();
+		m_block.max_end_time = std::numeric_limits<int64_t>::min();
+	}
+
+	m_segment_size += record_size;
+	m_block.end_offset = m_segment_size;
+	m_block.min_begin_time = std::min<int64_t>(m_block.min_begin_time, header.begin_time);
+	m_block.max_end_time = std::max<int64_t>(m_block.max_end_time, header.end_time);
+
+	if (++m_block_records == ARCHIVE_INDEX_STRIDE)
+		write_block();
+
+	return true;
+};
+
+void LPTrackArchive::flush()
+{
+	// Records first, so index never points past written data
+	if (!m_buffer.empty())
+	{
+		m_segment.write(m_buffer.data(), m_buffer.size());
+		m_buffer.clear();
+	}
+
+	m_segment.flush();
+	m_index.flush();
+};
+
+// Reader
+
+bool LPTrackRecordView::intersects(const cv::Rect& region) const
+{
+	for (size_t i = 0; i < rects_count; ++i)
+		if ((rects[i] & region).area() > 0)
+			return true;
+
+	return false;
+};
+
+bool LPTrackArchiveReader::open(const std::string& directory)
+{
+	m_segments.clear();
+
+	for (uint32_t number = 0; ; ++number)
+	{
+		Segment segment;
+		segment.filename = LPTrackArchive::segment_filename(directory, number);
+
+		if (!file_exists(segment.filename))
+			break;
+
+		// Index may be missing or incomplete: the rest of segment is scanned without it
+		std::ifstream index(LPTrackArchive::index_filename(directory, number).c_str(), std::fstream::binary);
+		LPArchiveIndexEntry entry;
+
+		while (index.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+			segment.index.push_back(entry);
+
+		m_segments.push_back(std::move(segment));
+	}
+
+	return !m_segments.empty();
+};
+
+size_t LPTrackArchiveReader::segments_count() const
+{
+	return m_segments.size();
+};
+
+size_t LPTrackArchiveReader::scan(long long from_time, long long to_time, const Callback& callback) const
+{
+	return scan_segments(from_time, to_time, nullptr, callback);
+};
+
+size_t LPTrackArchiveReader::scan(long long from_time, long long to_time, const cv::Rect& region, const Callback& callback) const
+{
+	return scan_segments(from_time, to_time, &region, callback);
+};
+
+size_t LPTrackArchiveReader::scan_segments(long long from_time, long long to_time, const cv::Rect* region, const Callback& callback) const
+{
+	size_t count = 0;
+
+	for (const auto& segment : m_segments)
+	{
+		MappedFile file;
+		if (!file.open(segment.filename) || file.size() < sizeof(LPArchiveSegmentHeader))
+			continue;
+
+		LPArchiveSegmentHeader header;
+		memcpy(&header, file.data(), sizeof(header));
+		if (header.magic != ARCHIVE_SEGMENT_MAGIC || header.version != ARCHIVE_VERSION)
+			continue;
+
+		size_t indexed_end = sizeof(LPArchiveSegmentHeader);
+
+		for (const auto& entry : segment.index)
+		{
+			if (entry.end_offset > file.size())
+				break;
+
+			indexed_end = static_cast<size_t>(entry.end_offset);
+
+			if (entry.min_begin_time > to_time || entry.max_end_time < from_time)
+				continue;
+
+			if (!scan_range(file, static_cast<size_t>(entry.begin_offset), indexed_end, from_time, to_time, region, callback, count))
+				return count;
+		}
+
+		// Tail without index
+		if (!scan_range(file, indexed_end, file.size(), from_time, to_time, region, callback, count))
+			return count;
+	}
+
+	return count;
+};
+
+bool LPTrackArchiveReader::scan_range(const MappedFile& file, size_t begin, size_t end, long long from_time, long long to_time, const cv::Rect* region, const Callback& callback, size_t& count) const
+{
+	LPTrackRecordView view;
+	size_t offset = begin;
+
+	while (offset < end && parse_record(file.data(), end, offset, view, offset))
+	{
+		if (view.begin_time > to_time || view.end_time < from_time)
+			continue;
+
+		if (region != nullptr && !view.intersects(*region))
+			continue;
+
+		++count;
+
+		if (!callback(view))
+			return false;
+	}
+
+	return true;
+};
+
+bool LPTrackArchiveReader::parse_record(const unsigned char* data, size_t size, size_t offset, LPTrackRecordView& view, size_t& next_offset)
+{
+	if (offset + sizeof(LPArchiveRecordHeader) > size)
+		return false;
+
+	LPArchiveRecordHeader header;
+	memcpy(&header, data + offset, sizeof(header));
+
+	if (header.magic != ARCHIVE_RECORD_MAGIC || header.size < sizeof(header) || header.size % 8 != 0 || offset + header.size > size)
+		return false;
+
+	const size_t rects_size = static_cast<size_t>(header.rects_count) * 4 * sizeof(int32_t);
+	size_t crop_size = 0;
+
+	if (header.crop_rows > 0 && header.crop_cols > 0)
+	{
+		// Corrupt header must not produce a bad Mat
+		if (header.crop_type < 0 || header.crop_type > CV_MAT_TYPE_MASK || CV_MAT_DEPTH(header.crop_type) > CV_64F)
+			return false;
+
+		const size_t crop_pixels = static_cast<size_t>(header.crop_rows) * static_cast<size_t>(header.crop_cols);
+		if (crop_pixels > header.size)
+			return false;
+
+		crop_size = crop_pixels * CV_ELEM_SIZE(header.crop_type);
+	}
+
+	if (sizeof(header) + rects_size + crop_size > header.size)
+		return false;
+
+	const unsigned char* rects = data + offset + sizeof(header);
+
+	view.id = header.id;
+	view.begin_time = header.begin_time;
+	view.end_time = header.end_time;
+	view.rects_count = header.rects_count;
+	view.rects = reinterpret_cast<const cv::Rect*>(rects);
+	view.crop_rect = cv::Rect(header.crop_rect[0], header.crop_rect[1], header.crop_rect[2], header.crop_rect[3]);
+
+	if (crop_size > 0)
+		view.crop = cv::Mat(header.crop_rows, header.crop_cols, header.crop_type, const_cast<unsigned char*>(rects + rects_size));
+	else
+		view.crop = cv::Mat();
+
+	next_offset = offset + header.size;
+	return true;
+};
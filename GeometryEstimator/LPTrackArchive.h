@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+
+#include "opencv2/imgproc.hpp"
+
+#include "LPTrackWriter.h"
+#include "MappedFile.h"
+
+#define ARCHIVE_SEGMENT_MAGIC 0x4741504Cu // "LPAG"
+#define ARCHIVE_RECORD_MAGIC 0x4345524Cu // "LREC"
+#define ARCHIVE_VERSION 1u
+#define ARCHIVE_SEGMENT_SIZE (64 * 1024 * 1024)
+#define ARCHIVE_INDEX_STRIDE 64
+
+// Append-only on-disk archive of finished tracks.
+// Directory holds numbered segments "segment_NNNNNN.lpa" with records and
+// sparse indexes "segment_NNNNNN.idx" with one entry per ARCHIVE_INDEX_STRIDE records.
+// Records are 8 bytes aligned: header, trajectory rects (int32 x, y, width, height), best crop pixels.
+// Times are milliseconds since epoch.
+
+struct LPArchiveSegmentHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t first_id;
+};
+
+struct LPArchiveRecordHeader
+{
+	uint32_t magic;
+	uint32_t size; // whole record with padding
+	uint64_t id;
+	int64_t begin_time;
+	int64_t end_time;
+	uint32_t rects_count;
+	int32_t crop_type;
+	int32_t crop_rect[4];
+	int32_t crop_rows;
+	int32_t crop_cols;
+};
+
+struct LPArchiveIndexEntry
+{
+	uint64_t begin_offset;
+	uint64_t end_offset;
+	int64_t min_begin_time;
+	int64_t max_end_time;
+};
+
+static_assert(sizeof(LPArchiveSegmentHeader) == 16, "Unexpected archive segment header layout");
+static_assert(sizeof(LPArchiveRecordHeader) == 64, "Unexpected archive record header layout");
+static_assert(sizeof(LPArchiveIndexEntry) == 32, "Unexpected archive index entry layout");
+
+// Writer: sink that appends tracks to the archive on its own thread
+class LPTrackArchive : public LPTrackWriter
+{
+private:
+	std::string m_directory;
+	uint32_t m_segment_number;
+	uint64_t m_segment_size;
+	std::ofstream m_segment;
+	std::ofstream m_index;
+	std::string m_buffer;
+
+	// Current index block
+	LPArchiveIndexEntry m_block;
+	size_t m_block_records;
+
+public:
+	LPTrackArchive();
+	~LPTrackArchive();
+
+	bool open(const std::string& directory);
+	void close();
+
+	static std::string segment_filename(const std::string& directory, uint32_t number);
+	static std::string index_filename(const std::string& directory, uint32_t number);
+
+protected:
+	bool write(uint64_t id, const LPTrack& track) override;
+	void flush() override;
+
+private:
+	bool open_segment(uint64_t first_id);
+	void close_segment();
+	void write_block();
+};
+
+// Zero-copy view of an archived record. Pointers are valid only inside scan callback.
+struct LPTrackRecordView
+{
+	uint64_t id;
+	long long begin_time;
+	long long end_time;
+	size_t rects_count;
+	const cv::Rect* rects;
+	cv::Rect crop_rect;
+	cv::Mat crop; // read-only mapped memory, clone to keep or modify
+
+	bool intersects(const cv::Rect& region) const;
+};
+
+// Reader: maps segments and scans records by time and position
+class LPTrackArchiveReader
+{
+public:
+	typedef std::function<bool(const LPTrackRecordView&)> Callback; // return false to stop scan
+
+private:
+	struct Segment
+	{
+		std::string filename;
+		std::vector<LPArchiveIndexEntry> index;
+	};
+
+	std::vector<Segment> m_segments;
+
+public:
+	LPTrackArchiveReader() = default;
+	~LPTrackArchiveReader() = default;
+
+	// Takes a snapshot of segments list, call again to see new segments
+	bool open(const std::string& directory);
+	size_t segments_count() const;
+
+	size_t scan(long long from_time, long long to_time, const Callback& callback) const;
+	size_t scan(long long from_time, long long to_time, const cv::Rect& region, const Callback& callback) const;
+
+	static bool parse_record(const unsigned char* data, size_t size, size_t offset, LPTrackRecordView& view, size_t& next_offset);
+
+private:
+	size_t scan_segments(long long from_time, long long to_time, const cv::Rect* region, const Callback& callback) const;
+	bool scan_range(const MappedFile& file, size_t begin, size_t end, long long from_time, long long to_time, const cv::Rect* region, const Callback& callback, size_t& count) const;
+};
@@ -0,0 +1,265 @@
+#include "LPTrackAssociator.h"
+
+LPTrackAssociator::LPTrackAssociator() :
+	m_finished_tracks(FINISHED_TRACKS_QUEUE_SIZE)
+{
+	m_is_processing.store(false);
+	m_assignment_solver.store(LPAssociation::Solver::lapjv);
+};
+
+void LPTrackAssociator::clear()
+{
+	assert(!m_is_processing.load());
+
+	m_tracks.clear();
+	m_pending_tracks.clear();
+
+	LPTrack track;
+	while (m_finished_tracks.try_pop(track)) {}
+};
+
+size_t LPTrackAssociator::tracks_count() const
+{
+	return m_tracks.size();
+};
+
+void LPTrackAssociator::pull_tracks(std::vector<LPTrack>& tracks)
+{
+	LPTrack track;
+
+	while (m_finished_tracks.try_pop(track))
+		tracks.push_back(std::move(track));
+};
+
+bool LPTrackAssociator::pop_track(LPTrack& track)
+{
+	return m_finished_tracks.try_pop(track);
+};
+
+bool LPTrackAssociator::wait_track(LPTrack& track, int timeout_ms)
+{
+	if (m_finished_tracks.try_pop(track))
+		return true;
+
+	// Producer notifies under the mutex after push, so the check below can't miss it
+	std::unique_lock<std::mutex> lock(m_finished_mutex);
+
+	if (!m_finished_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return !m_finished_tracks.empty(); }))
+		return false;
+
+	return m_finished_tracks.try_pop(track);
+};
+
+void LPTrackAssociator::set_track_sink(std::shared_ptr<LPTrackSink> sink)
+{
+	std::atomic_store(&m_track_sink, sink);
+};
+
+void LPTrackAssociator::push_finished_tracks()
+{
+	// Sink takes all tracks
+	auto sink = std::atomic_load(&m_track_sink);
+	if (sink)
+	{
+		for (auto& track : m_pending_tracks)
+			sink->push(std::move(track));
+
+		m_pending_tracks.clear();
+		return;
+	}
+
+	// Tracks that don't fit to the queue wait for the next frame
+	size_t pushed = 0;
+
+	while (pushed < m_pending_tracks.size() && m_finished_tracks.try_push(std::move(m_pending_tracks[pushed])))
+		++pushed;
+
+	m_pending_tracks.erase(m_pending_tracks.begin(), m_pending_tracks.begin() + pushed);
+
+	if (pushed > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_finished_mutex);
+		m_finished_condition.notify_all();
+	}
+};
+
+void LPTrackAssociator::set_assignment_solver(LPAssociation::Solver solver)
+{
+	m_assignment_solver.store(solver);
+};
+
+void LPTrackAssociator::process(const cv::Mat& frame, const std::vector<cv::Rect>& plates, const FrameTag& tag)
+{
+	const bool is_reentered = m_is_processing.exchange(true);
+	assert(!is_reentered);
+	(void)is_reentered;
+
+	std::vector<LPTrack>& tracks = m_tracks;
+
+	// Assign new plates to exisiting tracks
+	m_is_plate_assigned.assign(plates.size(), false);
+	m_is_track_assigned.assign(tracks.size(), false);
+
+	// Predict tracks positions for current frame
+	for (auto& track : tracks)
+		m_motion_model.predict(track.motion());
+
+	if (tracks.size() > 0 && plates.size() > 0)
+	{
+		// Put plates to spatial grid
+		double max_gate = 0.0;
+		m_plates_centers.resize(plates.size());
+
+		for (size_t j = 0; j < plates.size(); ++j)
+			m_plates_centers[j] = cv::Point(plates[j].x + (plates[j].width / 2), plates[j].y + (plates[j].height / 2));
+
+		for (size_t i = 0; i < tracks.size(); ++i)
+			max_gate = std::max(max_gate, search_radius(tracks[i]));
+
+		m_association.set_solver(m_assignment_solver.load());
+		m_association.init(tracks.size(), m_plates_centers, cvCeil(max_gate));
+
+		for (size_t i = 0; i < tracks.size(); ++i)
+		{
+			const auto& track = tracks[i];
+			assert(!track.get_trajectory()->empty());
+			const cv::Rect track_end_rect = track.last_rect();
+			const cv::Point2f tr_end_point = track.end_point();
+			const cv::Point2f tr_predicted_point = track.predicted_position();
+
+			const double max_angle = 30.0;
+			const double max_dist = 2.0 * cv::norm(track_end_rect.br() - track_end_rect.tl());
+
+			// Compute weights for gated pairs (track <-> plate)
+			m_association.find_plates(tr_predicted_point, search_radius(track), m_gated_plates);
+
+			for (auto j : m_gated_plates)
+			{
+				const cv::Point& plate_center = m_plates_centers[j];
+
+				double angle = 0.0;
+				double distance = 0.0;
+
+				// Estimate distance to predicted position
+				{
+					distance = cv::norm(tr_predicted_point - cv::Point2f(plate_center));
+				}
+
+				// Estimate vector angle between predicted and observed motion
+				{
+					const cv::Point2f ref_vec = tr_predicted_point - tr_end_point;
+					const cv::Point2f tar_vec = cv::Point2f(plate_center) - tr_end_point;
+
+					const double ref_vec_len = cv::norm(ref_vec);
+					const double tar_vec_len = cv::norm(tar_vec);
+					const double dot = ref_vec.x * tar_vec.x + ref_vec.y * tar_vec.y;
+
+					const double vec_len_mult = ref_vec_len * tar_vec_len;
+
+					if (abs(vec_len_mult) > DBL_EPSILON)
+					{
+						angle = dot / vec_len_mult;
+						angle = (angle >= 1.0) ? 0.0 : ((angle <= -1.0) ? 180.0 : DEGREE_IN_RADIAN * acos(angle));
+					}
+				}
+
+				// Estimate result weight
+				// NOTICE:    -  
+				// TODO:     0  1 
+
+				const double k_dist = 0.4;
+				const double k_angle = 0.4;
+				const double k_age = 0.2;
+
+				const double weight = k_dist * (distance / max_dist) + k_angle * (angle / max_angle) + k_age * (track.lost_frames() / MAX_MISSED_FRAMES);
+
+				if (weight < MAX_ASSIGN_WEIGHT)
+					m_association.add_candidate(i, j, weight);
+			}
+		}
+
+		m_association.solve(m_track_plates);
+
+		// Add assigned plates to tracks
+		for (size_t i = 0; i < tracks.size(); ++i)
+		{
+			if (m_track_plates[i] < 0)
+				continue;
+
+			const size_t j = static_cast<size_t>(m_track_plates[i]);
+			m_is_track_assigned[i] = true;
+			m_is_plate_assigned[j] = true;
+
+			auto& track = tracks[i];
+
+			// Confirm tentative track after enough hits
+			if (track.state() == LPTrack::State::tentative && track.get_trajectory()->size() + 1 >= CONFIRM_TRACK_HITS)
+			{
+				track.set_state(LPTrack::State::confirmed);
+				track.set_color(cv::Scalar(150 + rand() % 155, 0 + rand() % 255, 100 + rand() % 155));
+			}
+
+			// Crops are copied for confirmed tracks only
+			if (track.is_confirmed())
+			{
+				LPPlate new_plate;
+				new_plate.set_rect(plates[j]);
+				new_plate.set_image(LPCropAllocator::copy_crop(frame, plates[j]));
+				track.add_plate(new_plate, tag);
+			}
+			else
+				track.add_rect(plates[j], tag);
+
+			m_motion_model.correct(track.motion(), m_plates_centers[j]);
+		}
+	}
+
+	// Update unassigned tracks: tentative ones are dropped silently, confirmed ones become lost and finished
+	size_t kept = 0;
+
+	for (size_t i = 0; i < tracks.size(); ++i)
+	{
+		auto& track = tracks[i];
+
+		if (m_is_track_assigned[i])
+			track.clean_lost_frames();
+		else
+			track.inc_lost_frames();
+
+		if (!track.is_confirmed() && track.lost_frames() > TENTATIVE_MAX_MISSED_FRAMES)
+			continue;
+
+		if (track.is_confirmed() && track.lost_frames() > MAX_MISSED_FRAMES)
+		{
+			track.set_state(LPTrack::State::lost);
+			m_pending_tracks.push_back(std::move(track));
+			continue;
+		}
+
+		if (kept != i)
+			tracks[kept] = std::move(track);
+
+		++kept;
+	}
+
+	tracks.erase(tracks.begin() + kept, tracks.end());
+
+	// Create new tentative tracks
+	for (size_t i = 0; i < plates.size(); i++)
+		if (!m_is_plate_assigned[i])
+		{
+			tracks.emplace_back(plates[i], tag);
+			m_motion_model.init(tracks.back().motion(), tracks.back().end_point());
+		}
+
+	push_finished_tracks();
+	m_is_processing.store(false);
+};
+
+double LPTrackAssociator::search_radius(const LPTrack& track) const
+{
+	const cv::Rect rect = track.last_rect();
+	const double max_dist = 2.0 * cv::norm(rect.br() - rect.tl());
+
+	return 1.5 * max_dist + KALMAN_GATE_SIGMAS * track.position_uncertainty();
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include "opencv2/imgproc.hpp"
+
+#include "LPAssociation.h"
+#include "LPMotionModel.h"
+#include "LPCropAllocator.h"
+#include "SPSCQueue.h"
+#include "FrameIngest.h"
+#include "LPTrackSink.h"
+#include "LPTrack.h"
+#include "LPPlate.h"
+
+#define DEGREE_IN_RADIAN 57.295779513
+
+#define MAX_MISSED_FRAMES 5
+#define TENTATIVE_MAX_MISSED_FRAMES 1
+#define CONFIRM_TRACK_HITS 3 // >= 2, new tracks are always tentative
+#define MAX_ASSIGN_WEIGHT 1.0
+#define KALMAN_GATE_SIGMAS 3.0
+#define FINISHED_TRACKS_QUEUE_SIZE 1024
+
+// Association of detected plates with tracks of one camera.
+// process() is called by one thread at a time (checked by m_is_processing).
+// Finished tracks go to the sink if it is set, otherwise to a queue read by one consumer thread.
+
+class LPTrackAssociator
+{
+private:
+	std::vector<LPTrack> m_tracks;
+
+	// Finished tracks (moved from processing thread to consumer thread)
+	SPSCQueue<LPTrack> m_finished_tracks;
+	std::mutex m_finished_mutex;
+	std::condition_variable m_finished_condition;
+	std::vector<LPTrack> m_pending_tracks;
+
+	// Optional receiver of finished tracks (replaces the queue when set)
+	std::shared_ptr<LPTrackSink> m_track_sink;
+
+	// Motion prediction
+	LPMotionModel m_motion_model;
+
+	// Association (buffers are reused between frames)
+	std::atomic<bool> m_is_processing;
+	LPAssociation m_association;
+	std::atomic<LPAssociation::Solver> m_assignment_solver;
+	std::vector<bool> m_is_plate_assigned;
+	std::vector<bool> m_is_track_assigned;
+	std::vector<cv::Point> m_plates_centers;
+	std::vector<size_t> m_gated_plates;
+	std::vector<int> m_track_plates;
+
+public:
+	LPTrackAssociator();
+	~LPTrackAssociator() = default;
+
+	// Not while process() runs
+	void clear();
+	size_t tracks_count() const;
+
+	void process(const cv::Mat& frame, const std::vector<cv::Rect>& plates, const FrameTag& tag);
+
+	void pull_tracks(std::vector<LPTrack>& tracks);
+	bool pop_track(LPTrack& track);
+	bool wait_track(LPTrack& track, int timeout_ms);
+
+	void set_assignment_solver(LPAssociation::Solver solver);
+	void set_track_sink(std::shared_ptr<LPTrackSink> sink);
+
+private:
+	double search_radius(const LPTrack& track) const;
+	void push_finished_tracks();
+};
@@ -0,0 +1,183 @@
+#include "LPTrackEncoder.h"
+
+void LPTrackBinaryEncoder::encode(uint64_t id, const LPTrack& track, std::string& out)
+{
+	const size_t record_begin = out.size();
+	append(out, uint32_t(0)); // payload size, filled below
+
+	append(out, uint32_t(TRACK_BINARY_MAGIC));
+	append(out, uint32_t(TRACK_BINARY_VERSION));
+	append(out, id);
+
+	// Trajectory
+	const auto* trajectory = track.get_trajectory();
+	const auto* frames = track.get_frames();
+	append(out, static_cast<uint32_t>(trajectory->size()));
+
+	for (size_t i = 0; i < trajectory->size(); ++i)
+	{
+		const cv::Rect& rect = (*trajectory)[i];
+		append(out, int32_t(rect.x));
+		append(out, int32_t(rect.y));
+		append(out, int32_t(rect.width));
+		append(out, int32_t(rect.height));
+		append(out, (*frames)[i].sequence);
+		append(out, (*frames)[i].timestamp);
+	}
+
+	// Best crops
+	const auto* plates = track.get_plates();
+	append(out, static_cast<uint32_t>(plates->size()));
+
+	for (const auto& plate : *plates)
+	{
+		const cv::Rect* rect = plate.get_rect();
+		const cv::Mat* image = plate.get_image();
+		const bool has_image = image != nullptr && !image->empty();
+
+		append(out, int32_t(rect->x));
+		append(out, int32_t(rect->y));
+		append(out, int32_t(rect->width));
+		append(out, int32_t(rect->height));
+		append(out, int32_t(has_image ? image->rows : 0));
+		append(out, int32_t(has_image ? image->cols : 0));
+		append(out, int32_t(has_image ? image->type() : 0));
+
+		if (has_image)
+		{
+			const size_t row_size = image->cols * image->elemSize();
+			for (int r = 0; r < image->rows; ++r)
+				out.append(reinterpret_cast<const char*>(image->ptr(r)), row_size);
+		}
+	}
+
+	const uint32_t payload_size = static_cast<uint32_t>(out.size() - record_begin - sizeof(uint32_t));
+	out.replace(record_begin, sizeof(uint32_t), reinterpret_cast<const char*>(&payload_size), sizeof(uint32_t));
+};
+
+bool LPTrackBinaryEncoder::last_id(std::istream& in, uint64_t& id) const
+{
+	const std::streamoff header_size = 3 * sizeof(uint32_t) + sizeof(uint64_t);
+
+	in.seekg(0, std::ios::end);
+	const std::streamoff file_size = in.tellg();
+	std::streamoff offset = 0;
+	bool found = false;
+
+	// Walk records by their sizes, torn record at the end is not counted
+	while (offset + header_size <= file_size)
+	{
+		uint32_t payload_size = 0, magic = 0, version = 0;
+		uint64_t record_id = 0;
+
+		in.seekg(offset);
+		if (!read(in, payload_size) || !read(in, magic) || !read(in, version) || !read(in, record_id))
+			break;
+
+		offset += sizeof(uint32_t) + static_cast<std::streamoff>(payload_size);
+		if (magic != TRACK_BINARY_MAGIC || offset > file_size)
+			break;
+
+		id = record_id;
+		found = true;
+	}
+
+	return found;
+};
+
+void LPTrackJsonEncoder::encode(uint64_t id, const LPTrack& track, std::string& out)
+{
+	m_buffer.Clear();
+	rapidjson::Writer<rapidjson::StringBuffer> writer(m_buffer);
+
+	auto write_rect = [&writer](const cv::Rect& rect)
+	{
+		writer.StartArray();
+		writer.Int(rect.x);
+		writer.Int(rect.y);
+		writer.Int(rect.width);
+		writer.Int(rect.height);
+		writer.EndArray();
+	};
+
+	writer.StartObject();
+
+	writer.Key("id");
+	writer.Uint64(id);
+
+	writer.Key("begin_time");
+	writer.Int64(FrameIngest::to_system_ms(track.first_frame().timestamp));
+
+	writer.Key("end_time");
+	writer.Int64(FrameIngest::to_system_ms(track.last_frame().timestamp));
+
+	writer.Key("length");
+	writer.Double(track.lenght());
+
+	writer.Key("trajectory");
+	writer.StartArray();
+	for (const auto& rect : *track.get_trajectory())
+		write_rect(rect);
+	writer.EndArray();
+
+	writer.Key("frames");
+	writer.StartArray();
+	for (const auto& frame : *track.get_frames())
+		writer.Uint64(frame.sequence);
+	writer.EndArray();
+
+	writer.Key("crops");
+	writer.StartArray();
+	for (const auto& plate : *track.get_plates())
+		write_rect(*plate.get_rect());
+	writer.EndArray();
+
+	writer.EndObject();
+
+	out.append(m_buffer.GetString(), m_buffer.GetSize());
+	out.push_back('\n');
+};
+
+bool LPTrackJsonEncoder::last_id(std::istream& in, uint64_t& id) const
+{
+	in.seekg(0, std::ios::end);
+	std::streamoff position = in.tellg();
+
+	// Read the file backwards until the whole last line is in tail, text after the last '\n' is a torn record
+	std::string tail;
+	char chunk[4096];
+
+	while (position > 0)
+	{
+		const std::streamoff chunk_size = std::min<std::streamoff>(position, sizeof(chunk));
+		position -= chunk_size;
+
+		in.seekg(position);
+		if (!in.read(chunk, chunk_size))
+			return false;
+
+		tail.insert(0, chunk, static_cast<size_t>(chunk_size));
+
+		const size_t line_end = tail.rfind('\n');
+		if (line_end == std::string::npos)
+			continue;
+
+		const size_t line_begin = (line_end == 0) ? std::string::npos : tail.rfind('\n', line_end - 1);
+		if (line_begin == std::string::npos && position > 0)
+			continue;
+
+		const size_t first = (line_begin == std::string::npos) ? 0 : line_begin + 1;
+		const std::string line = tail.substr(first, line_end - first);
+
+		rapidjson::Document document;
+		document.Parse(line.c_str());
+
+		if (document.HasParseError() || !document.IsObject() || !document.HasMember("id") || !document["id"].IsUint64())
+			return false;
+
+		id = document["id"].GetUint64();
+		return true;
+	}
+
+	return false;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <istream>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+
+#include "LPTrack.h"
+
+#define TRACK_BINARY_MAGIC 0x4B52544Cu // "LTRK"
+#define TRACK_BINARY_VERSION 2u
+
+// Serializers of finished tracks. Every call appends exactly one record to out.
+// last_id() reads back the id of the last complete record, so appending to a file continues its ids.
+
+class LPTrackEncoder
+{
+public:
+	virtual ~LPTrackEncoder() = default;
+	virtual void encode(uint64_t id, const LPTrack& track, std::string& out) = 0;
+	// False if there is no complete record
+	virtual bool last_id(std::istream& in, uint64_t& id) const = 0;
+};
+
+// Length-prefixed binary record (native little-endian):
+// uint32 payload size | uint32 magic | uint32 version | uint64 id |
+// uint32 rects count | rects count * (int32[4] x, y, width, height, uint64 frame sequence, int64 frame timestamp) |
+// uint32 crops count | crops count * (int32[4] rect, int32 rows, int32 cols, int32 type, rows * cols * elem size bytes)
+class LPTrackBinaryEncoder : public LPTrackEncoder
+{
+public:
+	void encode(uint64_t id, const LPTrack& track, std::string& out) override;
+	bool last_id(std::istream& in, uint64_t& id) const override;
+
+private:
+	template<typename T>
+	static void append(std::string& out, const T& value)
+	{
+		out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	static bool read(std::istream& in, T& value)
+	{
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+};
+
+// One JSON object per line: {"id":..,"begin_time":..,"end_time":..,"length":..,
+// "trajectory":[[x,y,w,h],..],"frames":[sequence,..],"crops":[[x,y,w,h],..]}. Times are milliseconds since epoch.
+class LPTrackJsonEncoder : public LPTrackEncoder
+{
+private:
+	rapidjson::StringBuffer m_buffer;
+
+public:
+	void encode(uint64_t id, const LPTrack& track, std::string& out) override;
+	bool last_id(std::istream& in, uint64_t& id) const override;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "LPTrack.h"
+
+// Receiver of finished tracks.
+// push() is called from the thread that associates plates with tracks: the association thread of LPTracker
+// or any pool thread of LPTrackingService. One sink may be set for several trackers or streams,
+// so push() may be called from several threads at once: implementations must be thread safe and must not block.
+
+class LPTrackSink
+{
+public:
+	virtual ~LPTrackSink() = default;
+	virtual void push(LPTrack&& track) = 0;
+};
@@ -0,0 +1,141 @@
+#include "LPTrackWriter.h"
+
+LPTrackWriter::LPTrackWriter() : m_queue(TRACK_WRITER_QUEUE_SIZE)
+{
+	m_next_id = 0;
+	m_written_tracks.store(0);
+	m_dropped_tracks.store(0);
+	m_write_interruption.store(false);
+};
+
+LPTrackWriter::~LPTrackWriter()
+{
+	stop();
+};
+
+void LPTrackWriter::start(uint64_t first_id)
+{
+	stop();
+
+	m_next_id = first_id;
+	m_write_interruption.store(false);
+	m_write_thread = std::thread(&LPTrackWriter::write_thread_function, this);
+};
+
+void LPTrackWriter::stop()
+{
+	m_write_interruption.store(true);
+
+	if (m_write_thread.joinable())
+		m_write_thread.join();
+};
+
+void LPTrackWriter::push(LPTrack&& track)
+{
+	std::lock_guard<std::mutex> lock(m_push_mutex);
+
+	if (!m_queue.try_push(std::move(track)))
+		++m_dropped_tracks;
+};
+
+size_t LPTrackWriter::written_tracks() const
+{
+	return m_written_tracks.load();
+};
+
+size_t LPTrackWriter::dropped_tracks() const
+{
+	return m_dropped_tracks.load();
+};
+
+void LPTrackWriter::write_thread_function()
+{
+	LPTrack track;
+
+	while (true)
+	{
+		// Write all queued tracks, then flush once
+		size_t count = 0;
+
+		while (m_queue.try_pop(track))
+		{
+			// Id is taken only by written track
+			if (write(m_next_id, track))
+			{
+				++m_next_id;
+				++count;
+			}
+			else
+				++m_dropped_tracks;
+		}
+
+		if (count != 0)
+		{
+			flush();
+			m_written_tracks += count;
+			continue;
+		}
+
+		// Queue is empty: finish or wait
+		if (m_write_interruption.load())
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+};
+
+LPTrackFileWriter::LPTrackFileWriter(std::unique_ptr<LPTrackEncoder> encoder)
+{
+	p_encoder = std::move(encoder);
+};
+
+LPTrackFileWriter::~LPTrackFileWriter()
+{
+	close();
+};
+
+bool LPTrackFileWriter::open(const std::string& filename)
+{
+	close();
+
+	if (!p_encoder)
+		return false;
+
+	// Records are appended: ids continue after the last record of the file
+	uint64_t first_id = 0;
+	{
+		std::ifstream existing(filename.c_str(), std::fstream::in | std::fstream::binary);
+		uint64_t last_id = 0;
+
+		if (existing.is_open() && p_encoder->last_id(existing, last_id))
+			first_id = last_id + 1;
+	}
+
+	m_file.open(filename.c_str(), std::fstream::out | std::fstream::binary | std::fstream::app);
+	if (!m_file.is_open())
+		return false;
+
+	start(first_id);
+	return true;
+};
+
+void LPTrackFileWriter::close()
+{
+	stop();
+
+	if (m_file.is_open())
+		m_file.close();
+};
+
+bool LPTrackFileWriter::write(uint64_t id, const LPTrack& track)
+{
+	p_encoder->encode(id, track, m_buffer);
+	return true;
+};
+
+void LPTrackFileWriter::flush()
+{
+	m_file.write(m_buffer.data(), m_buffer.size());
+	m_file.flush();
+	m_buffer.clear();
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <fstream>
+
+#include "LPTrackSink.h"
+#include "LPTrackEncoder.h"
+#include "SPSCQueue.h"
+
+#define TRACK_WRITER_QUEUE_SIZE 4096
+
+// Track sink that writes tracks on its own thread.
+// Pushes of several producers are serialized, so one writer may be the sink of several streams.
+// If the writer can't keep up and the queue is full, or write() fails, tracks are dropped and counted.
+// Derived classes implement write() and flush() and must call stop() in their destructor.
+
+class LPTrackWriter : public LPTrackSink
+{
+private:
+	uint64_t m_next_id;
+
+	// Tracks queue (tracking threads -> writing thread), single producer at a time
+	std::mutex m_push_mutex;
+	SPSCQueue<LPTrack> m_queue;
+	std::atomic<size_t> m_written_tracks;
+	std::atomic<size_t> m_dropped_tracks;
+
+	// Writing
+	std::thread m_write_thread;
+	std::atomic<bool> m_write_interruption;
+
+public:
+	LPTrackWriter();
+	virtual ~LPTrackWriter();
+
+	void push(LPTrack&& track) override;
+
+	size_t written_tracks() const;
+	size_t dropped_tracks() const;
+
+protected:
+	void start(uint64_t first_id);
+	void stop();
+
+	// Called on writing thread, false if track couldn't be written and is dropped
+	virtual bool write(uint64_t id, const LPTrack& track) = 0;
+	virtual void flush() = 0;
+
+private:
+	void write_thread_function();
+};
+
+// Appends encoded tracks to a single file, ids continue after the last record already in it
+class LPTrackFileWriter : public LPTrackWriter
+{
+private:
+	std::unique_ptr<LPTrackEncoder> p_encoder;
+	std::ofstream m_file;
+	std::string m_buffer;
+
+public:
+	LPTrackFileWriter(std::unique_ptr<LPTrackEncoder> encoder);
+	~LPTrackFileWriter();
+
+	bool open(const std::string& filename);
+	void close();
+
+protected:
+	bool write(uint64_t id, const LPTrack& track) override;
+	void flush() override;
+};
@@ -3,6 +3,9 @@
 #include <memory>
 #include <algorithm>
 #include <thread>
+#include <map>
+#include <mutex>
+#include <condition_variable>
 
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/imgproc.hpp"
@@ -10,14 +13,13 @@
 #include "opencv2/highgui.hpp"
 
 #include "LPRecognizer.h"
-#include "LPTrack.h"
-#include "LPPlate.h"
+#include "LPTrackAssociator.h"
+#include "BlockingQueue.h"
+#include "FrameIngest.h"
+#include "LatencyHistogram.h"
 
-#include "munkres.h"
-
-#define DEGREE_IN_RADIAN 57.295779513
-
-#define MAX_MISSED_FRAMES 5
+#define CAPTURED_FRAMES_QUEUE_SIZE 4
+#define DETECTED_FRAMES_QUEUE_SIZE 8
 
 // TODOS:
 //   :   
@@ -25,40 +27,83 @@
 
 class LPTracker
 {
+public:
+	// Pipeline stages for latency accounting (microseconds)
+	enum class Stage
+	{
+		detection_wait, // from capture to detection start
+		detection,
+		association,
+		total,          // from capture to associated tracks
+		count
+	};
+
 private:
 
 	// Recognizer
 	std::unique_ptr<LPRecognizer> p_recognizer;
 
-	// Image capturing	
-	bool m_is_new_image;
-	cv::Mat m_gray_image;
-	std::mutex m_input_mutex;
-
-	// Tracks
-	std::mutex m_finished_tracks_mutex;
-	std::vector<LPTrack> m_finished_tracks;
-	std::vector<LPTrack> m_process_tracks;
+	// Pipeline: capture (caller thread) -> detection (several threads) -> association (one thread).
+	// Association gets frames back in capture order.
+	struct PipelineFrame
+	{
+		cv::Mat gray_image;
+		std::vector<cv::Rect> plates;
+		FrameTag tag;
+		size_t order = 0;
+	};
+
+	LatencyHistogram m_latency[static_cast<size_t>(Stage::count)];
+
+	FrameIngest m_ingest;
+	BlockingQueue<PipelineFrame> m_captured_frames;
+	BlockingQueue<PipelineFrame> m_detected_frames;
+
+	// Reorder window: detection holds a frame while it is too far ahead of the next frame
+	// to associate, so reorder buffer stays bounded and capture sees backpressure via full queues
+	std::mutex m_reorder_mutex;
+	std::condition_variable m_reorder_condition;
+	size_t m_next_order;
+	size_t m_reorder_capacity;
+
+	// Tracks: associator is used by the association thread while the pipeline is started,
+	// by the caller of process_plates otherwise
+	LPTrackAssociator m_associator;
 
 	// Processing
-	std::thread m_process_thread;
+	size_t m_detection_threads_count;
+	std::vector<std::thread> m_detection_threads;
+	std::thread m_association_thread;
 	std::atomic<bool> m_process_interruption;
 	std::atomic<bool> m_is_process_finished;
 
 public:
 	LPTracker();
-	~LPTracker() = default;
+	~LPTracker();
 
-	//bool init();
-	void clear();
+	bool init(size_t detection_threads = 1);
+	bool load_from_json(const std::string& filename);
+	// clear() and process_plates() fail while the pipeline is started,
+	// frames given to process_plates() are not counted in ingest_stats()
+	bool clear();
 	bool start_process();
 	bool stop_process();
 	bool capture_frame(const cv::Mat& frame);
+	bool capture_frame(const cv::Mat& frame, uint64_t& sequence);
+	void set_ingest_policy(FrameIngest::Policy policy, size_t nth = 1);
+	FrameIngest::Stats ingest_stats() const;
 	void pull_tracks(std::vector<LPTrack>& tracks);
-	void process_plates(const cv::Mat& frame, const std::vector<cv::Rect>& plates);
+	bool pop_track(LPTrack& track);
+	bool wait_track(LPTrack& track, int timeout_ms);
+	bool process_plates(const cv::Mat& frame, const std::vector<cv::Rect>& plates);
+	bool process_plates(const cv::Mat& frame, const std::vector<cv::Rect>& plates, const FrameTag& tag);
+	const LatencyHistogram& latency(Stage stage) const;
+	void reset_latency();
+	void set_assignment_solver(LPAssociation::Solver solver);
+	void set_track_sink(std::shared_ptr<LPTrackSink> sink);
 
 private:
-	void process_thread_function();
-	void process(const cv::Mat& frame, const std::vector<cv::Rect>& plates, std::vector<LPTrack>& tracks);
+	void detection_thread_function();
+	void association_thread_function();
 };
 
@@ -0,0 +1,246 @@
+#include "LPTrackingService.h"
+
+LPTrackingService::LPTrackingService(size_t threads_count) : m_pool(threads_count)
+{
+	p_detector = std::make_shared<LPPlateDetector>();
+	m_next_stream_id = 0;
+};
+
+LPTrackingService::~LPTrackingService()
+{
+	m_pool.stop();
+};
+
+bool LPTrackingService::init(const std::string& cascade_filename)
+{
+	return p_detector->init(cascade_filename, m_pool.threads_count());
+};
+
+int LPTrackingService::add_stream(const std::string& zones_filename, FrameIngest::Policy policy, size_t nth, size_t max_pending_frames)
+{
+	auto stream = std::make_shared<Stream>();
+
+	if (!stream->recognizer.load_from_json(zones_filename))
+		return -1;
+
+	stream->recognizer.set_detector(p_detector);
+	stream->ingest.set_policy(policy, nth);
+	stream->max_pending_frames = std::max<size_t>(1, max_pending_frames);
+	stream->zones_left.store(0);
+	stream->processed_frames.store(0);
+	stream->failed_tasks.store(0);
+
+	std::lock_guard<std::mutex> lock(m_streams_mutex);
+	stream->id = m_next_stream_id++;
+	m_streams[stream->id] = stream;
+
+	return static_cast<int>(stream->id);
+};
+
+bool LPTrackingService::remove_stream(int stream_id)
+{
+	// Tasks in flight keep the stream alive until they finish
+	std::lock_guard<std::mutex> lock(m_streams_mutex);
+	return m_streams.erase(static_cast<size_t>(stream_id)) > 0;
+};
+
+size_t LPTrackingService::streams_count()
+{
+	std::lock_guard<std::mutex> lock(m_streams_mutex);
+	return m_streams.size();
+};
+
+std::shared_ptr<LPTrackingService::Stream> LPTrackingService::find_stream(int stream_id)
+{
+	std::lock_guard<std::mutex> lock(m_streams_mutex);
+
+	auto it = m_streams.find(static_cast<size_t>(stream_id));
+	if (it == m_streams.end())
+		return nullptr;
+
+	return it->second;
+};
+
+bool LPTrackingService::capture_frame(int stream_id, const cv::Mat& frame)
+{
+	uint64_t sequence;
+	return capture_frame(stream_id, frame, sequence);
+};
+
+bool LPTrackingService::capture_frame(int stream_id, const cv::Mat& frame, uint64_t& sequence)
+{
+	if (frame.empty() || frame.size().area() == 0)
+		return false;
+
+	auto stream = find_stream(stream_id);
+	if (!stream)
+		return false;
+
+	const FrameTag tag = stream->ingest.next_tag();
+	sequence = tag.sequence;
+
+	if (stream->ingest.is_skipped(sequence))
+		return false;
+
+	cv::Mat gray_frame;
+
+	if (frame.type() != CV_8UC1)
+		cvtColor(frame, gray_frame, cv::COLOR_BGR2GRAY);
+	else
+		frame.copyTo(gray_frame);
+
+	std::lock_guard<std::mutex> lock(stream->mutex);
+
+	if (!stream->is_busy)
+	{
+		stream->is_busy = true;
+		start_frame(stream, std::move(gray_frame), tag);
+		return true;
+	}
+
+	// Stream is busy: wait in queue
+	if (stream->pending_frames.size() >= stream->max_pending_frames)
+	{
+		if (!stream->ingest.evicts_when_full())
+		{
+			stream->ingest.count_rejected();
+			return false;
+		}
+
+		stream->ingest.count_evicted();
+		stream->pending_frames.pop_front();
+	}
+
+	stream->pending_frames.emplace_back(std::move(gray_frame), tag);
+	return true;
+};
+
+void LPTrackingService::start_frame(const std::shared_ptr<Stream>& stream, cv::Mat&& frame, const FrameTag& tag)
+{
+	// Called with stream mutex locked, previous frame is finished
+	const auto zones = stream->recognizer.detection_zones();
+
+	stream->frame = std::move(frame);
+	stream->tag = tag;
+	stream->plates.clear();
+	stream->zones_left.store(zones.size());
+
+	if (zones.empty())
+	{
+		m_pool.submit([this, stream] { finish_frame(stream); });
+		return;
+	}
+
+	for (const auto& zone : zones)
+		m_pool.submit([this, stream, zone] { detect_zone(stream, zone.first, zone.second); });
+};
+
+void LPTrackingService::detect_zone(const std::shared_ptr<Stream>& stream, const cv::Rect& zone, const cv::Size& plate_size)
+{
+	const int64_t detection_start = FrameIngest::now();
+	m_latency[static_cast<size_t>(LPTracker::Stage::detection_wait)].record(detection_start - stream->tag.timestamp);
+
+	// Failed zone still counts as done, otherwise the stream stays busy forever
+	try
+	{
+		auto plates = stream->recognizer.detect_zone(stream->frame, zone, plate_size);
+
+		m_latency[static_cast<size_t>(LPTracker::Stage::detection)].record(FrameIngest::now() - detection_start);
+
+		if (!plates.empty())
+		{
+			std::lock_guard<std::mutex> lock(stream->plates_mutex);
+			stream->plates.insert(stream->plates.end(), plates.begin(), plates.end());
+		}
+	}
+	catch (...)
+	{
+		++stream->failed_tasks;
+	}
+
+	// The last zone task associates plates
+	if (--stream->zones_left == 0)
+		finish_frame(stream);
+};
+
+void LPTrackingService::finish_frame(const std::shared_ptr<Stream>& stream)
+{
+	// All zone tasks of the frame are finished here, plates are not touched by other threads
+	LPRecognizer::group_plates(stream->plates);
+
+	if (!stream->plates.empty())
+	{
+		const int64_t association_start = FrameIngest::now();
+
+		try
+		{
+			stream->associator.process(stream->frame, stream->plates, stream->tag);
+		}
+		catch (...)
+		{
+			++stream->failed_tasks;
+		}
+
+		m_latency[static_cast<size_t>(LPTracker::Stage::association)].record(FrameIngest::now() - association_start);
+	}
+
+	m_latency[static_cast<size_t>(LPTracker::Stage::total)].record(FrameIngest::now() - stream->tag.timestamp);
+	++stream->processed_frames;
+
+	// Next frame of this stream
+	std::lock_guard<std::mutex> lock(stream->mutex);
+
+	if (stream->pending_frames.empty())
+	{
+		stream->is_busy = false;
+		stream->frame.release();
+		return;
+	}
+
+	auto next = std::move(stream->pending_frames.front());
+	stream->pending_frames.pop_front();
+	start_frame(stream, std::move(next.first), next.second);
+};
+
+bool LPTrackingService::pull_tracks(int stream_id, std::vector<LPTrack>& tracks)
+{
+	auto stream = find_stream(stream_id);
+	if (!stream)
+		return false;
+
+	stream->associator.pull_tracks(tracks);
+	return true;
+};
+
+bool LPTrackingService::set_track_sink(int stream_id, std::shared_ptr<LPTrackSink> sink)
+{
+	auto stream = find_stream(stream_id);
+	if (!stream)
+		return false;
+
+	stream->associator.set_track_sink(sink);
+	return true;
+};
+
+size_t LPTrackingService::processed_frames(int stream_id)
+{
+	auto stream = find_stream(stream_id);
+	return stream ? stream->processed_frames.load() : 0;
+};
+
+size_t LPTrackingService::failed_tasks(int stream_id)
+{
+	auto stream = find_stream(stream_id);
+	return stream ? stream->failed_tasks.load() : 0;
+};
+
+const LatencyHistogram& LPTrackingService::latency(LPTracker::Stage stage) const
+{
+	return m_latency[static_cast<size_t>(stage)];
+};
+
+FrameIngest::Stats LPTrackingService::ingest_stats(int stream_id)
+{
+	auto stream = find_stream(stream_id);
+	return stream ? stream->ingest.stats() : FrameIngest::Stats();
+};
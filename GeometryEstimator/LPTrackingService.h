@@ -0,0 +1,97 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opencv2/imgproc.hpp"
+
+#include "WorkStealingPool.h"
+#include "LPPlateDetector.h"
+#include "LPRecognizer.h"
+#include "LPTracker.h"
+#include "LPTrackAssociator.h"
+#include "LPTrackSink.h"
+#include "FrameIngest.h"
+#include "LatencyHistogram.h"
+
+#define SERVICE_MAX_PENDING_FRAMES 2
+
+// Tracking of many camera streams on one shared worker pool.
+// All streams share one detector model (a cascade copy per pool thread).
+// Every stream has its own zones and tracks and processes one frame at a time:
+// the frame is split into zone detection tasks, the last finished task associates plates with tracks.
+// Frames that come while a stream is busy wait in a short per-stream queue with its ingest policy.
+
+class LPTrackingService
+{
+private:
+	struct Stream
+	{
+		size_t id = 0;
+		LPRecognizer recognizer;
+		LPTrackAssociator associator;
+
+		// Waiting frames
+		std::mutex mutex;
+		std::deque<std::pair<cv::Mat, FrameTag>> pending_frames;
+		size_t max_pending_frames = SERVICE_MAX_PENDING_FRAMES;
+		FrameIngest ingest;
+		bool is_busy = false;
+
+		// Frame in processing
+		cv::Mat frame;
+		FrameTag tag;
+		std::mutex plates_mutex;
+		std::vector<cv::Rect> plates;
+		std::atomic<size_t> zones_left;
+
+		// Statistics
+		std::atomic<size_t> processed_frames;
+		std::atomic<size_t> failed_tasks;
+	};
+
+	std::shared_ptr<LPPlateDetector> p_detector;
+
+	// Latency of all streams, detection is measured per zone task
+	LatencyHistogram m_latency[static_cast<size_t>(LPTracker::Stage::count)];
+
+	std::mutex m_streams_mutex;
+	std::map<size_t, std::shared_ptr<Stream>> m_streams;
+	size_t m_next_stream_id;
+
+	// Declared last: workers are stopped before streams and detector are destroyed
+	WorkStealingPool m_pool;
+
+public:
+	LPTrackingService(size_t threads_count);
+	~LPTrackingService();
+
+	bool init(const std::string& cascade_filename);
+
+	// Returns stream id or -1 if zones config can't be loaded
+	int add_stream(const std::string& zones_filename, FrameIngest::Policy policy = FrameIngest::Policy::latest_wins, size_t nth = 1, size_t max_pending_frames = SERVICE_MAX_PENDING_FRAMES);
+	bool remove_stream(int stream_id);
+	size_t streams_count();
+
+	bool capture_frame(int stream_id, const cv::Mat& frame);
+	bool capture_frame(int stream_id, const cv::Mat& frame, uint64_t& sequence);
+	bool pull_tracks(int stream_id, std::vector<LPTrack>& tracks);
+	bool set_track_sink(int stream_id, std::shared_ptr<LPTrackSink> sink);
+
+	size_t processed_frames(int stream_id);
+	// Zone detection and association tasks that threw: the frame is finished without their plates
+	size_t failed_tasks(int stream_id);
+	FrameIngest::Stats ingest_stats(int stream_id);
+	const LatencyHistogram& latency(LPTracker::Stage stage) const;
+
+private:
+	std::shared_ptr<Stream> find_stream(int stream_id);
+	void start_frame(const std::shared_ptr<Stream>& stream, cv::Mat&& frame, const FrameTag& tag);
+	void detect_zone(const std::shared_ptr<Stream>& stream, const cv::Rect& zone, const cv::Size& plate_size);
+	void finish_frame(const std::shared_ptr<Stream>& stream);
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <assert.h>
+#include <opencv2/core/core.hpp>
+
+// Rectangular linear assignment problem solver.
+// Shortest augmenting path method (Jonker-Volgenant) with dual potentials:
+// every row is assigned by one Dijkstra-like search over columns, no padding to square.
+// Output format of solve(cv::Mat) is the same as Munkres: 0 for assigned pairs, -1 otherwise.
+
+template<typename Data> class LapJV
+{
+private:
+	std::vector<double> m_u;
+	std::vector<double> m_v;
+	std::vector<double> m_shortest;
+	std::vector<int> m_path;
+	std::vector<int> m_col4row;
+	std::vector<int> m_row4col;
+	std::vector<int> m_remaining;
+	std::vector<char> m_sr;
+	std::vector<char> m_sc;
+	std::vector<Data> m_transposed;
+
+public:
+	/*
+	*
+	* cost: row major matrix rows x cols.
+	* row_assignment[row] is a column assigned to row or -1.
+	* Returns false if assignment is infeasible (infinite costs).
+	*
+	*/
+	bool solve(const Data* cost, size_t rows, size_t cols, int* row_assignment)
+	{
+		if (rows == 0 || cols == 0)
+		{
+			for (size_t i = 0; i < rows; ++i)
+				row_assignment[i] = -1;
+
+			return true;
+		}
+
+		// Algorithm needs rows <= cols
+		if (rows > cols)
+		{
+			m_transposed.resize(rows * cols);
+			for (size_t i = 0; i < rows; ++i)
+				for (size_t j = 0; j < cols; ++j)
+					m_transposed[j * rows + i] = cost[i * cols + j];
+
+			if (!solve_wide(m_transposed.data(), cols, rows))
+				return false;
+
+			for (size_t i = 0; i < rows; ++i)
+				row_assignment[i] = m_row4col[i];
+
+			return true;
+		}
+
+		if (!solve_wide(cost, rows, cols))
+			return false;
+
+		for (size_t i = 0; i < rows; ++i)
+			row_assignment[i] = m_col4row[i];
+
+		return true;
+	}
+
+	cv::Mat solve(const cv::Mat &mat)
+	{
+		assert(mat.type() == cv::DataType<Data>::type);
+
+		cv::Mat src = mat.isContinuous() ? mat : mat.clone();
+		std::vector<int> row_assignment(src.rows, -1);
+		cv::Mat res(src.rows, src.cols, CV_32SC1, cv::Scalar(-1));
+
+		if (solve(src.ptr<Data>(), src.rows, src.cols, row_assignment.data()))
+		{
+			for (int i = 0; i < src.rows; ++i)
+				if (row_assignment[i] >= 0)
+					res.at<int>(i, row_assignment[i]) = 0;
+		}
+
+		return res;
+	}
+
+private:
+	bool solve_wide(const Data* cost, size_t rows, size_t cols)
+	{
+		constexpr double infinity = std::numeric_limits<double>::infinity();
+
+		m_u.assign(rows, 0.0);
+		m_v.assign(cols, 0.0);
+		m_path.assign(cols, -1);
+		m_col4row.assign(rows, -1);
+		m_row4col.assign(cols, -1);
+		m_shortest.resize(cols);
+		m_remaining.resize(cols);
+		m_sr.resize(rows);
+		m_sc.resize(cols);
+
+		for (size_t cur_row = 0; cur_row < rows; ++cur_row)
+		{
+			// Find shortest augmenting path from cur_row to a free column
+			double min_val = 0.0;
+			int i = static_cast<int>(cur_row);
+			int sink = -1;
+			size_t num_remaining = cols;
+
+			for (size_t j = 0; j < cols; ++j)
+				m_remaining[j] = static_cast<int>(cols - j - 1);
+
+			std::fill(m_sr.begin(), m_sr.end(), 0);
+			std::fill(m_sc.begin(), m_sc.end(), 0);
+			std::fill(m_shortest.begin(), m_shortest.end(), infinity);
+
+			while (sink == -1)
+			{
+				int index = -1;
+				double lowest = infinity;
+				m_sr[i] = 1;
+
+				const Data* cost_row = cost + i * cols;
+
+				for (size_t it = 0; it < num_remaining; ++it)
+				{
+					const int j = m_remaining[it];
+					const double r = min_val + static_cast<double>(cost_row[j]) - m_u[i] - m_v[j];
+
+					if (r < m_shortest[j])
+					{
+						m_path[j] = i;
+						m_shortest[j] = r;
+					}
+
+					// Prefer free columns on ties: shorter augmentation
+					if (m_shortest[j] < lowest || (m_shortest[j] == lowest && m_row4col[j] == -1))
+					{
+						lowest = m_shortest[j];
+						index = static_cast<int>(it);
+					}
+				}
+
+				min_val = lowest;
+				if (min_val == infinity)
+					return false;
+
+				const int j = m_remaining[index];
+				if (m_row4col[j] == -1)
+					sink = j;
+				else
+					i = m_row4col[j];
+
+				m_sc[j] = 1;
+				m_remaining[index] = m_remaining[--num_remaining];
+			}
+
+			// Update dual potentials
+			m_u[cur_row] += min_val;
+			for (size_t r = 0; r < rows; ++r)
+				if (m_sr[r] && r != cur_row)
+					m_u[r] += min_val - m_shortest[m_col4row[r]];
+
+			for (size_t c = 0; c < cols; ++c)
+				if (m_sc[c])
+					m_v[c] -= min_val - m_shortest[c];
+
+			// Augment along the path
+			int j = sink;
+			while (true)
+			{
+				const int r = m_path[j];
+				m_row4col[j] = r;
+				std::swap(m_col4row[r], j);
+
+				if (r == static_cast<int>(cur_row))
+					break;
+			}
+		}
+
+		return true;
+	}
+};
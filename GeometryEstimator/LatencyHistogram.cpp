@@ -0,0 +1,108 @@
+#include "LatencyHistogram.h"
+
+#include <cmath>
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+};
+
+void LatencyHistogram::reset()
+{
+	for (auto& bucket : m_buckets)
+		bucket.store(0, std::memory_order_relaxed);
+
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+};
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+	if (value < LATENCY_LINEAR_LIMIT)
+		return static_cast<size_t>(value);
+
+	// Position of the highest bit, then next LATENCY_SUB_BUCKETS_BITS bits select sub bucket
+	size_t exponent = 0;
+	while ((value >> (exponent + 1)) != 0)
+		++exponent;
+
+	if (exponent >= LATENCY_MAX_EXPONENT)
+		return LATENCY_BUCKETS - 1;
+
+	const size_t sub = static_cast<size_t>(value >> (exponent - LATENCY_SUB_BUCKETS_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+	return LATENCY_LINEAR_LIMIT + (exponent - LATENCY_SUB_BUCKETS_BITS - 1) * LATENCY_SUB_BUCKETS + sub;
+};
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+	if (index < LATENCY_LINEAR_LIMIT)
+		return index;
+
+	const size_t exponent = (index - LATENCY_LINEAR_LIMIT) / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS_BITS + 1;
+	const uint64_t sub = (index - LATENCY_LINEAR_LIMIT) % LATENCY_SUB_BUCKETS;
+	const uint64_t step = uint64_t(1) << (exponent - LATENCY_SUB_BUCKETS_BITS);
+
+	return ((LATENCY_SUB_BUCKETS + sub) << (exponent - LATENCY_SUB_BUCKETS_BITS)) + step - 1;
+};
+
+void LatencyHistogram::record(int64_t value)
+{
+	const uint64_t positive = value > 0 ? static_cast<uint64_t>(value) : 0;
+
+	m_buckets[bucket_index(positive)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(positive, std::memory_order_relaxed);
+
+	int64_t current_max = m_max.load(std::memory_order_relaxed);
+	while (value > current_max && !m_max.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {}
+};
+
+uint64_t LatencyHistogram::count() const
+{
+	return m_count.load(std::memory_order_relaxed);
+};
+
+double LatencyHistogram::mean() const
+{
+	const uint64_t count = m_count.load(std::memory_order_relaxed);
+	if (count == 0)
+		return 0.0;
+
+	return static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count;
+};
+
+int64_t LatencyHistogram::max() const
+{
+	return m_max.load(std::memory_order_relaxed);
+};
+
+int64_t LatencyHistogram::percentile(double percent) const
+{
+	// Snapshot of buckets, counters may move while reading
+	uint64_t counts[LATENCY_BUCKETS];
+	uint64_t total = 0;
+
+	for (size_t i = 0; i < LATENCY_BUCKETS; ++i)
+	{
+		counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+
+	if (total == 0)
+		return 0;
+
+	percent = std::min(100.0, std::max(0.0, percent));
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percent / 100.0 * total)));
+
+	uint64_t accumulated = 0;
+	for (size_t i = 0; i < LATENCY_BUCKETS; ++i)
+	{
+		accumulated += counts[i];
+		if (accumulated >= rank)
+			return std::min<int64_t>(static_cast<int64_t>(bucket_upper_bound(i)), max());
+	}
+
+	return max();
+};
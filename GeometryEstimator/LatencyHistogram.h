@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#define LATENCY_SUB_BUCKETS_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKETS_BITS)
+#define LATENCY_LINEAR_LIMIT (2 * LATENCY_SUB_BUCKETS)
+#define LATENCY_MAX_EXPONENT 40
+#define LATENCY_BUCKETS (LATENCY_LINEAR_LIMIT + (LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKETS_BITS) * LATENCY_SUB_BUCKETS)
+
+// Lock-free histogram of latencies in microseconds.
+// Log-linear buckets: exact below LATENCY_LINEAR_LIMIT, then every power of two is split
+// into LATENCY_SUB_BUCKETS, so relative error of percentiles is below 1 / LATENCY_SUB_BUCKETS.
+// record() is a couple of relaxed atomic increments and may be called from any thread.
+
+class LatencyHistogram
+{
+private:
+	std::atomic<uint64_t> m_buckets[LATENCY_BUCKETS];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sum;
+	std::atomic<int64_t> m_max;
+
+public:
+	LatencyHistogram();
+	~LatencyHistogram() = default;
+
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	void record(int64_t value);
+	void reset();
+
+	uint64_t count() const;
+	double mean() const;
+	int64_t max() const;
+
+	// Percentile in [0, 100]: upper bound of bucket with the rank
+	int64_t percentile(double percent) const;
+
+private:
+	static size_t bucket_index(uint64_t value);
+	static uint64_t bucket_upper_bound(size_t index);
+};
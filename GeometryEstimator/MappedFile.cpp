@@ -0,0 +1,125 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	m_data = nullptr;
+	m_size = 0;
+
+#ifdef _WIN32
+	m_file_handle = INVALID_HANDLE_VALUE;
+	m_mapping_handle = nullptr;
+#else
+	m_file_descriptor = -1;
+#endif
+};
+
+MappedFile::~MappedFile()
+{
+	close();
+};
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+#ifdef _WIN32
+	m_file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file_handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(m_file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping_handle = CreateFileMappingA(m_file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping_handle == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+	m_file_descriptor = ::open(filename.c_str(), O_RDONLY);
+	if (m_file_descriptor < 0)
+		return false;
+
+	struct stat file_stat;
+	if (fstat(m_file_descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, m_file_descriptor, 0);
+	m_data = data == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(data);
+	m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+};
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping_handle != nullptr)
+		CloseHandle(m_mapping_handle);
+
+	if (m_file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file_handle);
+
+	m_file_handle = INVALID_HANDLE_VALUE;
+	m_mapping_handle = nullptr;
+#else
+	if (m_data != nullptr)
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+
+	if (m_file_descriptor >= 0)
+		::close(m_file_descriptor);
+
+	m_file_descriptor = -1;
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+};
+
+bool MappedFile::is_open() const
+{
+	return m_data != nullptr;
+};
+
+const unsigned char* MappedFile::data() const
+{
+	return m_data;
+};
+
+size_t MappedFile::size() const
+{
+	return m_size;
+};
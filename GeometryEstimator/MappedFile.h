@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file.
+
+class MappedFile
+{
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+
+#ifdef _WIN32
+	void* m_file_handle;
+	void* m_mapping_handle;
+#else
+	int m_file_descriptor;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& filename);
+	void close();
+
+	bool is_open() const;
+	const unsigned char* data() const;
+	size_t size() const;
+};
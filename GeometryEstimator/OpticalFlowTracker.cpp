@@ -3,42 +3,165 @@
 OpticalFlowTracker::OpticalFlowTracker()
 {
 	p_termcrit = std::make_unique<cv::TermCriteria>(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01);
+	m_detector_mode = DetectorMode::shi_tomasi;
+	m_scale = 1.0;
 	clear();
 };
 
 void OpticalFlowTracker::clear()
 {
 	m_initial_loop = true;
+	m_replenish_cell = 0;
 	m_points_prev.clear();
 	m_process_tracks.clear();
-	m_finished_tracks.clear();
+	m_xs.clear();
+	m_ys.clear();
+	m_arena_garbage = 0;
+	m_finished_xs.clear();
+	m_finished_ys.clear();
+	m_finished_offsets.assign(1, 0);
 	m_gray_prev.release();
+	m_pyramid_prev.clear();
 };
 
 size_t OpticalFlowTracker::tracks_count() const
 {
-	return m_finished_tracks.size();
+	return m_finished_offsets.size() - 1;
 };
 
 void OpticalFlowTracker::get_tracks(std::vector<std::vector<cv::Point2f>>& tracks) const
 {
-	tracks.resize(m_finished_tracks.size());
+	tracks.resize(tracks_count());
 
-	for (size_t i = 0; i < m_finished_tracks.size(); ++i)
+	for (size_t i = 0; i < tracks.size(); ++i)
 	{
-		tracks[i] = m_finished_tracks[i].points;
+		tracks[i].resize(m_finished_offsets[i + 1] - m_finished_offsets[i]);
+
+		for (size_t j = 0; j < tracks[i].size(); ++j)
+			tracks[i][j] = cv::Point2f(m_finished_xs[m_finished_offsets[i] + j], m_finished_ys[m_finished_offsets[i] + j]);
 	}
 };
 
+const std::vector<float>& OpticalFlowTracker::tracks_xs() const
+{
+	return m_finished_xs;
+};
+
+const std::vector<float>& OpticalFlowTracker::tracks_ys() const
+{
+	return m_finished_ys;
+};
+
+const std::vector<size_t>& OpticalFlowTracker::tracks_offsets() const
+{
+	return m_finished_offsets;
+};
+
+cv::Point2f OpticalFlowTracker::track_point(const Track& track, size_t i) const
+{
+	return cv::Point2f(m_xs[track.offset + i], m_ys[track.offset + i]);
+};
+
+void OpticalFlowTracker::start_track(const cv::Point2f& point)
+{
+	Track track;
+	track.offset = m_xs.size();
+	track.capacity = TRACK_INITIAL_CAPACITY;
+
+	m_xs.resize(m_xs.size() + track.capacity);
+	m_ys.resize(m_ys.size() + track.capacity);
+	m_process_tracks.push_back(track);
+
+	add_point(m_process_tracks.back(), point);
+};
+
+void OpticalFlowTracker::add_point(Track& track, const cv::Point2f& point)
+{
+	// Full block: move it to the end with doubled capacity
+	if (track.size == track.capacity)
+	{
+		const size_t offset = m_xs.size();
+
+		m_xs.resize(offset + 2 * track.capacity);
+		m_ys.resize(offset + 2 * track.capacity);
+		std::copy_n(m_xs.begin() + track.offset, track.size, m_xs.begin() + offset);
+		std::copy_n(m_ys.begin() + track.offset, track.size, m_ys.begin() + offset);
+
+		m_arena_garbage += track.capacity;
+		track.offset = offset;
+		track.capacity *= 2;
+	}
+
+	m_xs[track.offset + track.size] = point.x;
+	m_ys[track.offset + track.size] = point.y;
+	++track.size;
+	track.fit.add(point);
+};
+
+void OpticalFlowTracker::finish_track(const Track& track)
+{
+	m_arena_garbage += track.capacity;
+
+	if (track.size <= MIN_TRACK_SIZE)
+		return;
+
+	m_finished_xs.insert(m_finished_xs.end(), m_xs.begin() + track.offset, m_xs.begin() + track.offset + track.size);
+	m_finished_ys.insert(m_finished_ys.end(), m_ys.begin() + track.offset, m_ys.begin() + track.offset + track.size);
+	m_finished_offsets.push_back(m_finished_xs.size());
+
+	if (p_vp_estimator)
+		p_vp_estimator->add_track(track.fit, track_point(track, 0), track_point(track, track.size - 1));
+};
+
+void OpticalFlowTracker::set_vp_estimator(std::shared_ptr<StreamingVPEstimator> estimator)
+{
+	p_vp_estimator = estimator;
+};
+
+void OpticalFlowTracker::compact_arena()
+{
+	if (m_arena_garbage * 2 <= m_xs.size())
+		return;
+
+	m_xs_swap.clear();
+	m_ys_swap.clear();
+
+	for (auto& track : m_process_tracks)
+	{
+		const size_t offset = m_xs_swap.size();
+
+		m_xs_swap.insert(m_xs_swap.end(), m_xs.begin() + track.offset, m_xs.begin() + track.offset + track.capacity);
+		m_ys_swap.insert(m_ys_swap.end(), m_ys.begin() + track.offset, m_ys.begin() + track.offset + track.capacity);
+		track.offset = offset;
+	}
+
+	m_xs.swap(m_xs_swap);
+	m_ys.swap(m_ys_swap);
+	m_arena_garbage = 0;
+};
+
 bool OpticalFlowTracker::process_frame(const cv::Mat &frame)
 {
-	cv::Mat gray_frame;
 	std::vector<cv::Point2f> points;
 
 	if (frame.empty() || frame.size().area() == 0)
 		return false;
 
-	if (frame.type() != CV_8UC1)
+	// Buffers of the frame before previous one are reused
+	cv::Mat& gray_frame = m_gray;
+	const float to_full = static_cast<float>(1.0 / m_scale);
+
+	if (m_scale < 1.0)
+	{
+		if (frame.type() != CV_8UC1)
+		{
+			cvtColor(frame, m_gray_full, cv::COLOR_BGR2GRAY);
+			cv::resize(m_gray_full, gray_frame, cv::Size(), m_scale, m_scale, cv::INTER_AREA);
+		}
+		else
+			cv::resize(frame, gray_frame, cv::Size(), m_scale, m_scale, cv::INTER_AREA);
+	}
+	else if (frame.type() != CV_8UC1)
 		cvtColor(frame, gray_frame, cv::COLOR_BGR2GRAY);
 	else
 		frame.copyTo(gray_frame);
@@ -46,85 +169,301 @@ bool OpticalFlowTracker::process_frame(const cv::Mat &frame)
 	cv::Size lk_win_size = { static_cast<int>(std::max(std::round(gray_frame.cols * LK_WIN_SIZE_SCALE), 3.0)),
 							 static_cast<int>(std::max(std::round(gray_frame.rows * LK_WIN_SIZE_SCALE), 3.0)) };
 
-	if (m_initial_loop)
+	// Pyramid is built once and used as previous one on the next frame
+	cv::buildOpticalFlowPyramid(gray_frame, m_pyramid, lk_win_size, LK_PYRAMID_LEVELS);
+
+	// Track existing points
+	if (!m_initial_loop && !m_points_prev.empty())
 	{
-		const double min_dist = std::ceil(FEAUTERS_DIST_MIN * sqrt(gray_frame.cols * gray_frame.rows));
-		cv::goodFeaturesToTrack(gray_frame, points, MAX_FEATURES, 0.01, min_dist);
-		cv::cornerSubPix(gray_frame, points, cv::Size(min_dist, min_dist), cv::Size(-1, -1), *p_termcrit);
+		if (m_gray_prev.size() != gray_frame.size())				
+			return false;
 
-		m_process_tracks.clear();
-		m_process_tracks.resize(points.size());
+		std::vector<float> err;
+		std::vector<uchar> status;
+		cv::calcOpticalFlowPyrLK(m_pyramid_prev, m_pyramid, m_points_prev, points, status, err, lk_win_size, LK_PYRAMID_LEVELS, *p_termcrit, 0, 0.005);
 
-		for (size_t i = 0; i < points.size(); ++i)
+		size_t i, k;
+		for (i = k = 0; i < points.size(); ++i)
 		{
-			m_process_tracks[i].points.push_back(points[i]);
-			m_process_tracks[i].missed_frames = 0;
+			if (status[i] == 0 || m_process_tracks[i].missed_frames > MAX_MISSED_FRAMES)
+			{
+				finish_track(m_process_tracks[i]);
+				continue;
+			}
+
+			// Geometry checks in full resolution
+			const cv::Point2f point = points[i] * to_full;
+		
+			if (is_straight(m_process_tracks[i], point))
+			{
+				const Track& track = m_process_tracks[i];
+
+				if (cv::norm(track_point(track, track.size - 1) - point) < 5.0)
+				{
+					++m_process_tracks[i].missed_frames;
+				}
+				else
+				{
+					add_point(m_process_tracks[i], point);
+					m_process_tracks[i].missed_frames = 0;
+				}
+			}
+			else
+			{
+				finish_track(m_process_tracks[i]);
+				continue;
+			}
+
+			// Only track headers are moved, points stay in the arena
+			points[k] = points[i];
+			m_process_tracks[k] = m_process_tracks[i];
+			++k;
 		}
 
-		m_initial_loop = false;
+		points.resize(k);
+		m_process_tracks.resize(k);
+		compact_arena();
 	}
-	else
+
+	// Detect new features in cells without tracks
+	replenish_features(gray_frame, points);
+	m_initial_loop = false;
+
+	m_points_prev.swap(points);
+	cv::swap(m_gray, m_gray_prev);
+	m_pyramid.swap(m_pyramid_prev);
+
+	return true;
+};
+
+bool OpticalFlowTracker::is_straight(const Track& track, const cv::Point2f& point)
+{
+	// Robust check of the last points: all of them lie near a line through two of them
+	const size_t window = std::min<size_t>(track.size, TRACK_FIT_WINDOW - 1);
+
+	m_window_points.clear();
+	for (size_t i = track.size - window; i < track.size; ++i)
+		m_window_points.push_back(track_point(track, i));
+
+	m_window_points.push_back(point);
+
+	// Only the inliers count matters: the line is not refined
+	RansacParams params;
+	params.refine = false;
+
+	LineF line_result;
+	if (!fitLineRansac(TRACK_FIT_THRESH, m_window_points.size(), m_window_points, line_result, params, m_window_workspace))
+		return false;
+
+	// Whole track: least squares residual stays within threshold
+	LineFitAccumulator fit = track.fit;
+	fit.add(point);
+
+	return fit.mean_squared_residual() <= TRACK_FIT_THRESH * TRACK_FIT_THRESH;
+};
+
+void OpticalFlowTracker::replenish_features(const cv::Mat& gray_frame, std::vector<cv::Point2f>& points)
+{
+	if (points.size() >= MAX_FEATURES)
+		return;
+
+	const size_t cells_count = FEATURE_GRID_SIZE * FEATURE_GRID_SIZE;
+	const double cell_width = static_cast<double>(gray_frame.cols) / FEATURE_GRID_SIZE;
+	const double cell_height = static_cast<double>(gray_frame.rows) / FEATURE_GRID_SIZE;
+
+	// Cells with live tracks
+	m_cell_occupied.assign(cells_count, 0);
+
+	for (const auto& point : points)
 	{
-		if (!m_points_prev.empty())
-		{
-			if (m_gray_prev.size() != gray_frame.size())				
-				return false;
+		const int cx = std::min(std::max(static_cast<int>(point.x / cell_width), 0), FEATURE_GRID_SIZE - 1);
+		const int cy = std::min(std::max(static_cast<int>(point.y / cell_height), 0), FEATURE_GRID_SIZE - 1);
+		m_cell_occupied[cy * FEATURE_GRID_SIZE + cx] = 1;
+	}
 
-			std::vector<float> err;
-			std::vector<uchar> status;
-			cv::calcOpticalFlowPyrLK(m_gray_prev, gray_frame, m_points_prev, points, status, err, lk_win_size, 3, *p_termcrit, 0, 0.005);
+	// Select empty cells round robin, so every cell gets its turn
+	size_t features_left = MAX_FEATURES - points.size();
+	m_cell_tasks.clear();
 
-			size_t i, k;
-			for (i = k = 0; i < points.size(); ++i)
-			{
-				if (status[i] == 0 || m_process_tracks[i].missed_frames > MAX_MISSED_FRAMES)
-				{
-					if (m_process_tracks[i].points.size() > MIN_TRACK_SIZE)
-						m_finished_tracks.push_back(m_process_tracks[i]);
+	for (size_t n = 0; n < cells_count && m_cell_tasks.size() < FEATURE_CELLS_BUDGET && features_left > 0; ++n)
+	{
+		const size_t cell = (m_replenish_cell + n) % cells_count;
+		if (m_cell_occupied[cell])
+			continue;
 
-					continue;
-				}
-			
-				LineF line_result;
-				std::vector<cv::Point2f> line_points;
-				line_points.insert(std::end(line_points), std::begin(m_process_tracks[i].points), std::end(m_process_tracks[i].points));
-				line_points.push_back(points[i]);
+		const int cx = static_cast<int>(cell % FEATURE_GRID_SIZE);
+		const int cy = static_cast<int>(cell / FEATURE_GRID_SIZE);
+
+		CellTask task;
+		task.roi = cv::Rect(cv::Point(cvRound(cx * cell_width), cvRound(cy * cell_height)),
+							cv::Point(cvRound((cx + 1) * cell_width), cvRound((cy + 1) * cell_height)));
+		task.max_corners = std::min<size_t>(FEATURES_PER_CELL, features_left);
+
+		features_left -= task.max_corners;
+		m_replenish_cell = (cell + 1) % cells_count;
+
+		if (task.roi.area() > 0)
+			m_cell_tasks.push_back(task);
+	}
+
+	if (m_cell_tasks.empty())
+		return;
+
+	// Detect in cells: in parallel if there is a pool
+	const double min_dist = std::ceil(FEAUTERS_DIST_MIN * sqrt(gray_frame.cols * gray_frame.rows));
 
-				if (fitLineRansac(1.5, line_points.size(), line_points, line_result))
+	if (p_pool && m_cell_tasks.size() > 1)
+	{
+		// Caller and pool tasks take cells from the common counter.
+		// Exceptions are caught in tasks and rethrown here after all tasks are done
+		std::atomic<size_t> next_cell(0);
+		size_t helpers_left = m_cell_tasks.size() - 1;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable done;
+
+		auto detect_cells = [this, &gray_frame, min_dist, &next_cell]
+		{
+			for (size_t i = next_cell++; i < m_cell_tasks.size(); i = next_cell++)
+				detect_cell(gray_frame, min_dist, m_cell_tasks[i]);
+		};
+
+		for (size_t i = 0; i < m_cell_tasks.size() - 1; ++i)
+		{
+			p_pool->submit([&detect_cells, &helpers_left, &error, &mutex, &done]
+			{
+				std::exception_ptr task_error;
+
+				try
 				{
-					if (cv::norm(m_process_tracks[i].points.back() - points[i]) < 5.0)
-					{
-						++m_process_tracks[i].missed_frames;
-					}
-					else
-					{
-						m_process_tracks[i].points.push_back(points[i]);
-						m_process_tracks[i].missed_frames = 0;
-					}
+					detect_cells();
 				}
-				else
+				catch (...)
 				{
-					if (m_process_tracks[i].points.size() > MIN_TRACK_SIZE)
-						m_finished_tracks.push_back(m_process_tracks[i]);
-
-					continue;
+					task_error = std::current_exception();
 				}
 
-				points[k] = points[i];
-				m_process_tracks[k] = m_process_tracks[i];
-				++k;
-			}
+				std::lock_guard<std::mutex> lock(mutex);
+				if (task_error && !error)
+					error = task_error;
 
-			points.resize(k);
-			m_process_tracks.resize(k);
+				--helpers_left;
+				done.notify_one();
+			});
 		}
-		else
+
+		try
 		{
-			m_initial_loop = true;
+			detect_cells();
+		}
+		catch (...)
+		{
+			// Other cells are not taken any more, tasks only finish
+			next_cell.store(m_cell_tasks.size());
+
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&helpers_left] { return helpers_left == 0; });
+			throw;
 		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&helpers_left] { return helpers_left == 0; });
+
+		if (error)
+			std::rethrow_exception(error);
 	}
+	else
+	{
+		for (auto& task : m_cell_tasks)
+			detect_cell(gray_frame, min_dist, task);
+	}
+
+	m_new_points.clear();
+	for (const auto& task : m_cell_tasks)
+		m_new_points.insert(m_new_points.end(), task.points.begin(), task.points.end());
+
+	if (m_new_points.empty())
+		return;
+
+	// Refine on the whole frame: refinement window may cross cell border
+	cv::cornerSubPix(gray_frame, m_new_points, cv::Size(min_dist, min_dist), cv::Size(-1, -1), *p_termcrit);
+
+	const float to_full = static_cast<float>(1.0 / m_scale);
+
+	for (const auto& point : m_new_points)
+	{
+		start_track(point * to_full);
+		points.push_back(point);
+	}
+};
+
+void OpticalFlowTracker::detect_cell(const cv::Mat& gray_frame, double min_dist, CellTask& task) const
+{
+	const cv::Point2f offset(static_cast<float>(task.roi.x), static_cast<float>(task.roi.y));
+	task.points.clear();
+
+	if (m_detector_mode == DetectorMode::shi_tomasi)
+	{
+		cv::goodFeaturesToTrack(gray_frame(task.roi), task.points, static_cast<int>(task.max_corners), 0.01, min_dist);
+
+		for (auto& point : task.points)
+			point += offset;
+
+		return;
+	}
+
+	// FAST: strongest corners not closer than min_dist to each other
+	std::vector<cv::KeyPoint> keypoints;
+	cv::FAST(gray_frame(task.roi), keypoints, FAST_THRESHOLD, true);
+
+	std::sort(keypoints.begin(), keypoints.end(), [](const cv::KeyPoint& a, const cv::KeyPoint& b)
+	{
+		return a.response > b.response;
+	});
 
+	for (const auto& keypoint : keypoints)
+	{
+		if (task.points.size() >= task.max_corners)
+			break;
+
+		const cv::Point2f point = keypoint.pt + offset;
+		const bool is_far = std::all_of(task.points.begin(), task.points.end(), [&point, min_dist](const cv::Point2f& other)
+		{
+			return cv::norm(point - other) >= min_dist;
+		});
+
+		if (is_far)
+			task.points.push_back(point);
+	}
+};
+
+void OpticalFlowTracker::set_detector(DetectorMode mode, size_t threads_count)
+{
+	m_detector_mode = mode;
+
+	if (threads_count > 1)
+		p_pool = std::make_unique<WorkStealingPool>(threads_count);
+	else
+		p_pool.reset();
+};
+
+double OpticalFlowTracker::scale() const
+{
+	return m_scale;
+};
+
+void OpticalFlowTracker::set_scale(double scale)
+{
+	// Live tracks are kept in full frame coordinates: finish them as they are
+	for (const auto& track : m_process_tracks)
+		finish_track(track);
+
+	// Points of the previous frame are in old scale
+	m_scale = std::min(std::max(scale, WORK_SCALE_MIN), 1.0);
 	m_points_prev.clear();
-	m_points_prev.insert(std::end(m_points_prev), std::begin(points), std::end(points));
-	gray_frame.copyTo(m_gray_prev);
+	m_process_tracks.clear();
+	m_xs.clear();
+	m_ys.clear();
+	m_arena_garbage = 0;
+	m_initial_loop = true;
 };
@@ -1,7 +1,10 @@
 #pragma once
+#include <mutex>
 #include <memory>
 #include <vector>
+#include <exception>
 #include <algorithm>
+#include <condition_variable>
 
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/imgproc.hpp"
@@ -9,30 +12,98 @@
 #include "opencv2/highgui.hpp"
 #include "opencv2/video.hpp"
 #include "opencv2/objdetect.hpp"
+#include "opencv2/features2d.hpp"
 
 #include "GeometryCommon.h"
+#include "GeometryBatch.h"
+#include "WorkStealingPool.h"
+#include "StreamingVPEstimator.h"
 
 #define MIN_TRACK_SIZE 8
 #define MAX_MISSED_FRAMES 15
 
 #define MAX_FEATURES 100
 #define LK_WIN_SIZE_SCALE 0.025
+#define LK_PYRAMID_LEVELS 3
+#define WORK_SCALE_MIN 0.1
 #define FEAUTERS_DIST_MIN 0.01
 
+// Features replenishment: frame is split into grid cells, new features are searched
+// only in cells without live tracks, at most FEATURE_CELLS_BUDGET cells per frame
+#define FEATURE_GRID_SIZE 8
+#define FEATURE_CELLS_BUDGET 16
+#define FEATURES_PER_CELL 2
+#define FAST_THRESHOLD 20
+
+#define TRACK_FIT_THRESH 1.5
+#define TRACK_FIT_WINDOW 8
+#define TRACK_INITIAL_CAPACITY 16
+
 class OpticalFlowTracker
 {
+public:
+	// Corners detector used in grid cells
+	enum class DetectorMode
+	{
+		shi_tomasi,
+		fast
+	};
+
 private:
+	// Points of a track are block [offset, offset + size) of the arena
 	struct Track
 	{
-		std::vector<cv::Point2f> points;
+		size_t offset = 0;
+		size_t size = 0;
+		size_t capacity = 0;
+		LineFitAccumulator fit;
 		size_t missed_frames = 0;
 	};
 
+	// Detection and LK run on frames downscaled by m_scale,
+	// tracks keep full resolution coordinates
+	double m_scale;
+	cv::Mat m_gray_full;
+
+	// Current and previous frames with their LK pyramids (swapped every frame)
+	cv::Mat m_gray;
 	cv::Mat m_gray_prev;
+	std::vector<cv::Mat> m_pyramid;
+	std::vector<cv::Mat> m_pyramid_prev;
 	bool m_initial_loop;
 	std::vector<Track> m_process_tracks;
-	std::vector<Track> m_finished_tracks;
+
+	// Arena of processed tracks points: blocks grow by relocation to the end,
+	// space of dropped and relocated blocks is reclaimed by compaction
+	std::vector<float> m_xs;
+	std::vector<float> m_ys;
+	std::vector<float> m_xs_swap;
+	std::vector<float> m_ys_swap;
+	size_t m_arena_garbage;
+
+	// Finished tracks packed one after another: track i is [offsets[i], offsets[i + 1])
+	std::vector<float> m_finished_xs;
+	std::vector<float> m_finished_ys;
+	std::vector<size_t> m_finished_offsets;
+	std::shared_ptr<StreamingVPEstimator> p_vp_estimator;
 	std::vector<cv::Point2f> m_points_prev;
+	std::vector<cv::Point2f> m_window_points;
+	RansacWorkspace m_window_workspace;
+
+	// Replenishment (cells may be searched on a pool)
+	struct CellTask
+	{
+		cv::Rect roi;
+		size_t max_corners = 0;
+		std::vector<cv::Point2f> points;
+	};
+
+	DetectorMode m_detector_mode;
+	std::unique_ptr<WorkStealingPool> p_pool;
+	size_t m_replenish_cell;
+	std::vector<char> m_cell_occupied;
+	std::vector<CellTask> m_cell_tasks;
+	std::vector<cv::Point2f> m_new_points;
 	std::unique_ptr<cv::TermCriteria> p_termcrit;
 
 public:
@@ -42,7 +113,28 @@ public:
 	void clear();
 	size_t tracks_count() const;
 	bool process_frame(const cv::Mat& frame);	
+	void set_detector(DetectorMode mode, size_t threads_count = 1);
+	double scale() const;
+	void set_scale(double scale);
 	void get_tracks(std::vector<std::vector<cv::Point2f>>& tracks) const;
+
+	// Finished tracks without copying
+	const std::vector<float>& tracks_xs() const;
+	const std::vector<float>& tracks_ys() const;
+	const std::vector<size_t>& tracks_offsets() const;
+
+	// Finished tracks are passed to estimator as they appear
+	void set_vp_estimator(std::shared_ptr<StreamingVPEstimator> estimator);
+
+private:
+	cv::Point2f track_point(const Track& track, size_t i) const;
+	void start_track(const cv::Point2f& point);
+	void add_point(Track& track, const cv::Point2f& point);
+	void finish_track(const Track& track);
+	void compact_arena();
+	bool is_straight(const Track& track, const cv::Point2f& point);
+	void replenish_features(const cv::Mat& gray_frame, std::vector<cv::Point2f>& points);
+	void detect_cell(const cv::Mat& gray_frame, double min_dist, CellTask& task) const;
 };
 
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <assert.h>
+
+// Bounded lock-free single-producer/single-consumer queue.
+// try_push() must be called from one thread only and try_pop() from one (other) thread only.
+// Values are moved in and out, popped slots are reset to release their resources.
+
+template<typename T>
+class SPSCQueue
+{
+private:
+	std::vector<T> m_buffer;
+	size_t m_mask;
+
+	// Head and tail are kept on different cache lines
+	char m_pad0[64];
+	std::atomic<size_t> m_head;
+	char m_pad1[64];
+	std::atomic<size_t> m_tail;
+	char m_pad2[64];
+
+public:
+	explicit SPSCQueue(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+
+		m_buffer.resize(size);
+		m_mask = size - 1;
+		m_head.store(0);
+		m_tail.store(0);
+	}
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	size_t capacity() const
+	{
+		return m_buffer.size();
+	}
+
+	// Approximate when called concurrently
+	size_t size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// Producer side. Value is left untouched if queue is full.
+	bool try_push(T&& value)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		if (tail - head >= m_buffer.size())
+			return false;
+
+		m_buffer[tail & m_mask] = std::move(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool try_pop(T& value)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		const size_t tail = m_tail.load(std::memory_order_acquire);
+
+		if (head == tail)
+			return false;
+
+		value = std::move(m_buffer[head & m_mask]);
+		m_buffer[head & m_mask] = T();
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+};
@@ -0,0 +1,111 @@
+#include "StreamingVPEstimator.h"
+
+StreamingVPEstimator::StreamingVPEstimator()
+{
+	init(cv::Point2i(1, 1), false);
+};
+
+void StreamingVPEstimator::init(cv::Point2i frame_size, bool ontop)
+{
+	m_frame_size = cv::Point2i(std::max(frame_size.x, 1), std::max(frame_size.y, 1));
+	m_ontop = ontop;
+
+	m_origin = cv::Point2d(-VP_GRID_MARGIN * m_frame_size.x, -VP_GRID_MARGIN * m_frame_size.y);
+	m_cell_size = cv::Point2d((1.0 + 2.0 * VP_GRID_MARGIN) * m_frame_size.x / VP_GRID_CELLS,
+							  (1.0 + 2.0 * VP_GRID_MARGIN) * m_frame_size.y / VP_GRID_CELLS);
+	m_length_ref = sqrt(static_cast<double>(m_frame_size.x) * m_frame_size.x + static_cast<double>(m_frame_size.y) * m_frame_size.y);
+
+	clear();
+};
+
+void StreamingVPEstimator::clear()
+{
+	m_votes.assign(VP_GRID_CELLS * VP_GRID_CELLS, 0.0);
+	m_best_cell = -1;
+	m_total_weight = 0.0;
+	m_lines_count = 0;
+};
+
+cv::Point2d StreamingVPEstimator::cell_center(int cx, int cy) const
+{
+	return cv::Point2d(m_origin.x + (cx + 0.5) * m_cell_size.x, m_origin.y + (cy + 0.5) * m_cell_size.y);
+};
+
+void StreamingVPEstimator::add_line(const LineF& line)
+{
+	const double length = line.length();
+	if (length < DBL_EPSILON)
+		return;
+
+	m_line.clear();
+	m_line.push_back(line);
+
+	// Only cells of the line cone are visited, the best cell follows the votes
+	const float y_max = m_ontop ? static_cast<float>(m_frame_size.y) / 2.0f : FLT_MAX;
+	rotherVoteCells(m_line, 0, m_origin, m_cell_size, VP_GRID_CELLS, VP_GRID_CELLS, y_max, m_length_ref, m_votes.data(), &m_best_cell);
+
+	m_total_weight += ROTHER_COEF_ANG + ROTHER_COEF_LEN * length / m_length_ref;
+	++m_lines_count;
+};
+
+void StreamingVPEstimator::add_track(const LineFitAccumulator& fit, const cv::Point2f& first, const cv::Point2f& last)
+{
+	cv::Point2f center, direction;
+	if (!fit.line(center, direction))
+		return;
+
+	// Segment of the fitted line between projections of the track ends
+	const float first_proj = (first - center).dot(direction);
+	const float last_proj = (last - center).dot(direction);
+
+	add_line(LineF(center + direction * first_proj, center + direction * last_proj));
+};
+
+size_t StreamingVPEstimator::lines_count() const
+{
+	return m_lines_count;
+};
+
+bool StreamingVPEstimator::has_peak() const
+{
+	if (m_best_cell < 0)
+		return false;
+
+	// Peak at the border: vanishing point is probably beyond the grid
+	const int best_x = m_best_cell % VP_GRID_CELLS;
+	const int best_y = m_best_cell / VP_GRID_CELLS;
+
+	return best_x > 0 && best_x < VP_GRID_CELLS - 1 && best_y > 0 && best_y < VP_GRID_CELLS - 1;
+};
+
+bool StreamingVPEstimator::vanishing_point(cv::Point2f& vpoint) const
+{
+	if (!has_peak())
+		return false;
+
+	const int best_x = m_best_cell % VP_GRID_CELLS;
+	const int best_y = m_best_cell / VP_GRID_CELLS;
+
+	// Weighted center of the best cell neighbourhood
+	cv::Point2d sum;
+	double weight = 0.0;
+
+	for (int cy = std::max(best_y - 1, 0); cy <= std::min(best_y + 1, VP_GRID_CELLS - 1); ++cy)
+		for (int cx = std::max(best_x - 1, 0); cx <= std::min(best_x + 1, VP_GRID_CELLS - 1); ++cx)
+		{
+			const double votes = m_votes[cy * VP_GRID_CELLS + cx];
+			sum += cell_center(cx, cy) * votes;
+			weight += votes;
+		}
+
+	vpoint = cv::Point2f(static_cast<float>(sum.x / weight), static_cast<float>(sum.y / weight));
+	return true;
+};
+
+double StreamingVPEstimator::confidence() const
+{
+	if (!has_peak() || m_total_weight < DBL_EPSILON)
+		return 0.0;
+
+	return m_votes[m_best_cell] / m_total_weight;
+};
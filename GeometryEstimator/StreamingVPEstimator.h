@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "opencv2/imgproc.hpp"
+
+#include "GeometryCommon.h"
+#include "GeometryBatch.h"
+
+#define VP_GRID_CELLS 128
+#define VP_GRID_MARGIN 0.5
+
+// Incremental vanishing point estimation.
+// Plane around the frame (VP_GRID_MARGIN of frame size on each side) is split into
+// VP_GRID_CELLS x VP_GRID_CELLS cells. Every added line adds its Rother weight to the cells of its cone
+// (rotherVoteCells), so adding is O(rows + cone cells) and the best cell is kept up to date:
+// vanishing point and confidence are read in O(1).
+// Vanishing points beyond the grid can't be represented: lines of such a point pile up their votes
+// at the grid border, so a peak in a border cell means "not found" (unlike EstimateRotherVP, which searches far regions).
+// Unlike EstimateRotherVP, length term is normalized by the frame diagonal, not by the longest line,
+// so earlier votes stay valid when longer lines arrive.
+
+class StreamingVPEstimator
+{
+private:
+	cv::Point2i m_frame_size;
+	bool m_ontop;
+	cv::Point2d m_origin;
+	cv::Point2d m_cell_size;
+	double m_length_ref;
+
+	std::vector<double> m_votes;
+	int m_best_cell;
+	double m_total_weight;
+	size_t m_lines_count;
+
+	// Added line as a batch of one for rotherWeights
+	LineBatch m_line;
+
+public:
+	StreamingVPEstimator();
+	~StreamingVPEstimator() = default;
+
+	void init(cv::Point2i frame_size, bool ontop);
+	void clear();
+
+	void add_line(const LineF& line);
+	// Track given by its line fit and end points: the fit is not repeated
+	void add_track(const LineFitAccumulator& fit, const cv::Point2f& first, const cv::Point2f& last);
+
+	size_t lines_count() const;
+	// False if there are no votes yet or the peak is at the grid border
+	bool vanishing_point(cv::Point2f& vpoint) const;
+	// Weight of the best cell relative to the weight of all lines: [0, 1], zero if there is no vanishing point
+	double confidence() const;
+
+private:
+	cv::Point2d cell_center(int cx, int cy) const;
+	bool has_peak() const;
+};
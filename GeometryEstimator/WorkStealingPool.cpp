@@ -0,0 +1,123 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t threads_count)
+{
+	threads_count = std::max<size_t>(1, threads_count);
+
+	m_next_worker.store(0);
+	m_pending_tasks.store(0);
+	m_failed_tasks.store(0);
+	m_interruption.store(false);
+
+	for (size_t i = 0; i < threads_count; ++i)
+		m_workers.push_back(std::make_unique<Worker>());
+
+	for (size_t i = 0; i < threads_count; ++i)
+		m_threads.emplace_back(&WorkStealingPool::worker_function, this, i);
+};
+
+WorkStealingPool::~WorkStealingPool()
+{
+	stop();
+};
+
+void WorkStealingPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_idle_mutex);
+		m_interruption.store(true);
+	}
+
+	m_idle_condition.notify_all();
+
+	for (auto& thread : m_threads)
+		if (thread.joinable())
+			thread.join();
+
+	m_threads.clear();
+};
+
+void WorkStealingPool::submit(Task task)
+{
+	const size_t index = m_next_worker++ % m_workers.size();
+
+	// Counted before push, so the counter never goes below zero
+	{
+		std::lock_guard<std::mutex> lock(m_idle_mutex);
+		++m_pending_tasks;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+		m_workers[index]->tasks.push_back(std::move(task));
+	}
+
+	m_idle_condition.notify_one();
+};
+
+size_t WorkStealingPool::threads_count() const
+{
+	return m_workers.size();
+};
+
+size_t WorkStealingPool::pending_tasks() const
+{
+	return m_pending_tasks.load();
+};
+
+size_t WorkStealingPool::failed_tasks() const
+{
+	return m_failed_tasks.load();
+};
+
+bool WorkStealingPool::take_task(size_t index, Task& task)
+{
+	// Own deque first, then steal: oldest task in both cases
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		Worker& victim = *m_workers[(index + i) % m_workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+};
+
+void WorkStealingPool::worker_function(size_t index)
+{
+	Task task;
+
+	while (!m_interruption.load())
+	{
+		if (take_task(index, task))
+		{
+			--m_pending_tasks;
+
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				++m_failed_tasks;
+			}
+
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_idle_mutex);
+		m_idle_condition.wait_for(lock, std::chrono::milliseconds(10), [this]
+		{
+			return m_interruption.load() || m_pending_tasks.load() > 0;
+		});
+	}
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+// Thread pool with a task deque per worker.
+// Tasks are spread round robin, also when submitted from a worker, and every deque is served oldest first:
+// continuation tasks of a busy submitter queue behind older tasks of others instead of overtaking them.
+// Idle workers steal the oldest tasks of other workers.
+
+class WorkStealingPool
+{
+public:
+	typedef std::function<void()> Task;
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::thread> m_threads;
+	std::atomic<size_t> m_next_worker;
+	std::atomic<size_t> m_pending_tasks;
+	std::atomic<size_t> m_failed_tasks;
+	std::atomic<bool> m_interruption;
+
+	// Sleeping of idle workers
+	std::mutex m_idle_mutex;
+	std::condition_variable m_idle_condition;
+
+public:
+	explicit WorkStealingPool(size_t threads_count);
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	void submit(Task task);
+	size_t threads_count() const;
+	size_t pending_tasks() const;
+	// Tasks that threw: the exception is dropped, tasks report errors to their owners themselves
+	size_t failed_tasks() const;
+
+	// Stops workers, not started tasks are dropped
+	void stop();
+
+private:
+	void worker_function(size_t index);
+	bool take_task(size_t index, Task& task);
+};
@@ -12,6 +12,7 @@
 #include "LPTracker.h"
 #include "LPTrack.h"
 #include "FrameCapture.h"
+#include "AssignmentBenchmark.h"
 
 using namespace std;
 
@@ -27,6 +28,12 @@ int main(int argc, char** argv)
 	LPTracker lptracker;
 	LPRecognizer lprecognizer;
 
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-assignment")
+	{
+		benchmark_assignment_solvers(1000);
+		return 0;
+	}
+
 	if (!debugger.open_video("..\\videos\\5_x2.mp4"))
 	{
 		cout << "Could not open video file. \r\n";
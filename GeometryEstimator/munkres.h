@@ -22,7 +22,7 @@
 
 #include "matrix.h"
 
-#include <list>
+#include <vector>
 #include <utility>
 #include <iostream>
 #include <cmath>
@@ -49,45 +49,128 @@ public:
 	*/
 	void solve(Matrix<Data> &m) {
 		const size_t rows = m.rows(),
-			columns = m.columns(),
-			size = std::max(rows, columns);
+			columns = m.columns();
 
 #ifdef DEBUG
 		std::cout << "Munkres input: " << m << std::endl;
 #endif
 
-		// Copy input matrix
-		this->matrix = m;
+		load(rows, columns, [&](size_t row, size_t col) { return m(row, col); });
+		run();
 
-		if (rows != columns) {
-			// If the input matrix isn't square, make it square
-			// and fill the empty values with the largest value present
-			// in the matrix.
-			matrix.resize(size, size, matrix.max());
+		// Store results
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < columns; col++) {
+				m(row, col) = (mask(row, col) == STAR) ? 0 : -1;
+			}
 		}
 
+#ifdef DEBUG
+		std::cout << "Munkres output: " << m << std::endl;
+#endif
+	}
 
-		// STAR == 1 == starred, PRIME == 2 == primed
-		mask_matrix.resize(size, size);
+	cv::Mat solve(const cv::Mat &mat) 
+	{
+		load(mat.rows, mat.cols, [&](size_t row, size_t col) { return mat.at<Data>(static_cast<int>(row), static_cast<int>(col)); });
+		run();
 
-		row_mask = new bool[size];
-		col_mask = new bool[size];
-		for (size_t i = 0; i < size; i++) {
-			row_mask[i] = false;
+		cv::Mat res(mat.rows, mat.cols, CV_32SC1);
+		for (int i = 0; i < mat.rows; i++)
+		{
+			for (int j = 0; j < mat.cols; j++)
+			{
+				res.at<int>(i, j) = (mask(i, j) == STAR) ? 0 : -1;
+			}
+		}
+		return res;
+	}
+
+	/*
+	*
+	* Solution for caller-provided row major cost buffer (rows x columns).
+	* row_assignment[row] is a column assigned to row or -1.
+	* Workspace is kept between calls, so there are no allocations
+	* once the object has solved a problem of the same or bigger size.
+	*
+	*/
+	bool solve(const Data *cost, size_t rows, size_t columns, int *row_assignment) {
+		if (rows == 0 || columns == 0) {
+			for (size_t row = 0; row < rows; row++) {
+				row_assignment[row] = -1;
+			}
+			return true;
 		}
 
-		for (size_t i = 0; i < size; i++) {
-			col_mask[i] = false;
+		load(rows, columns, [&](size_t row, size_t col) { return cost[row * columns + col]; });
+		run();
+
+		for (size_t row = 0; row < rows; row++) {
+			row_assignment[row] = -1;
+			for (size_t col = 0; col < columns; col++) {
+				if (mask(row, col) == STAR) {
+					row_assignment[row] = static_cast<int>(col);
+					break;
+				}
+			}
 		}
 
+		return true;
+	}
+
+private:
+
+	inline Data& cell(const size_t row, const size_t col) {
+		return matrix[row * size + col];
+	}
+
+	inline const Data& cell(const size_t row, const size_t col) const {
+		return matrix[row * size + col];
+	}
+
+	inline int& mask(const size_t row, const size_t col) {
+		return mask_matrix[row * size + col];
+	}
+
+	/*
+	* Copy input to the square contiguous workspace.
+	* Missing rows or columns are filled with the largest value present in the input.
+	*/
+	template<typename Getter>
+	void load(const size_t rows, const size_t columns, Getter get) {
+		assert(rows > 0 && columns > 0);
+		size = std::max(rows, columns);
+		wide = (rows < columns);
+
+		Data max = get(0, 0);
+		for (size_t row = 0; row < rows; row++) {
+			for (size_t col = 0; col < columns; col++) {
+				max = std::max<Data>(max, get(row, col));
+			}
+		}
+
+		matrix.resize(size * size);
+		for (size_t row = 0; row < size; row++) {
+			for (size_t col = 0; col < size; col++) {
+				cell(row, col) = (row < rows && col < columns) ? get(row, col) : max;
+			}
+		}
+	}
+
+	void run() {
+		// STAR == 1 == starred, PRIME == 2 == primed
+		mask_matrix.assign(size * size, static_cast<int>(NORMAL));
+		row_mask.assign(size, false);
+		col_mask.assign(size, false);
+
 		// Prepare the matrix values...
 
 		// If there were any infinities, replace them with a value greater
 		// than the maximum value in the matrix.
-		replace_infinites(matrix);
+		replace_infinites();
 
-		minimize_along_direction(matrix, rows >= columns);
-		minimize_along_direction(matrix, rows <  columns);
+		minimize_along_direction(!wide);
+		minimize_along_direction(wide);
 
 		// Follow the steps
 		int step = 1;
@@ -115,74 +198,20 @@ public:
 				break;
 			}
 		}
-
-		// Store results
-		for (size_t row = 0; row < size; row++) {
-			for (size_t col = 0; col < size; col++) {
-				if (mask_matrix(row, col) == STAR) {
-					matrix(row, col) = 0;
-				}
-				else {
-					matrix(row, col) = -1;
-				}
-			}
-		}
-
-#ifdef DEBUG
-		std::cout << "Munkres output: " << matrix << std::endl;
-#endif
-		// Remove the excess rows or columns that we added to fit the
-		// input to a square matrix.
-		matrix.resize(rows, columns);
-
-		m = matrix;
-
-		delete[] row_mask;
-		delete[] col_mask;
-	}
-
-	cv::Mat solve(const cv::Mat &mat) 
-	{
-		Matrix<Data> matrix(mat.rows, mat.cols);
-		for (size_t i = 0; i < mat.rows; i++)
-		{
-			for (size_t j = 0; j < mat.cols; j++)
-			{
-				matrix(i, j) = mat.at<Data>(i, j);
-			}
-		}
-
-		Munkres<Data> m;
-		m.solve(matrix);
-
-		cv::Mat res(matrix.rows(), matrix.columns(), CV_32SC1);
-		for (size_t i = 0; i < mat.rows; i++)
-		{
-			for (size_t j = 0; j < mat.cols; j++)
-			{
-				res.at<int>(i, j) = matrix(i, j);
-			}
-		}
-		return res;
 	}
 
-	static void replace_infinites(Matrix<Data> &matrix) {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
-		assert(rows > 0 && columns > 0);
-		double max = matrix(0, 0);
+	void replace_infinites() {
+		double max = cell(0, 0);
 		constexpr auto infinity = std::numeric_limits<double>::infinity();
 
 		// Find the greatest value in the matrix that isn't infinity.
-		for (size_t row = 0; row < rows; row++) {
-			for (size_t col = 0; col < columns; col++) {
-				if (matrix(row, col) != infinity) {
-					if (max == infinity) {
-						max = matrix(row, col);
-					}
-					else {
-						max = std::max<double>(max, matrix(row, col));
-					}
+		for (size_t i = 0; i < size * size; i++) {
+			if (matrix[i] != infinity) {
+				if (max == infinity) {
+					max = matrix[i];
+				}
+				else {
+					max = std::max<double>(max, matrix[i]);
 				}
 			}
 		}
@@ -196,58 +225,47 @@ public:
 			max++;
 		}
 
-		for (size_t row = 0; row < rows; row++) {
-			for (size_t col = 0; col < columns; col++) {
-				if (matrix(row, col) == infinity) {
-					matrix(row, col) = max;
-				}
+		for (size_t i = 0; i < size * size; i++) {
+			if (matrix[i] == infinity) {
+				matrix[i] = max;
 			}
 		}
-
 	}
 
-	static void minimize_along_direction(Matrix<Data> &matrix, const bool over_columns) {
-		const size_t outer_size = over_columns ? matrix.columns() : matrix.rows(),
-			inner_size = over_columns ? matrix.rows() : matrix.columns();
-
+	void minimize_along_direction(const bool over_columns) {
 		// Look for a minimum value to subtract from all values along
 		// the "outer" direction.
-		for (size_t i = 0; i < outer_size; i++) {
-			double min = over_columns ? matrix(0, i) : matrix(i, 0);
+		for (size_t i = 0; i < size; i++) {
+			double min = over_columns ? cell(0, i) : cell(i, 0);
 
 			// As long as the current minimum is greater than zero,
 			// keep looking for the minimum.
-			// Start at one because we already have the 0th value in min.
-			for (size_t j = 1; j < inner_size && min > 0; j++) {
+			for (size_t j = 1; j < size && min > 0; j++) {
 				min = std::min<double>(
 					min,
-					over_columns ? matrix(j, i) : matrix(i, j));
+					over_columns ? cell(j, i) : cell(i, j));
 			}
 
 			if (min > 0) {
-				for (size_t j = 0; j < inner_size; j++) {
+				for (size_t j = 0; j < size; j++) {
 					if (over_columns) {
-						matrix(j, i) -= min;
+						cell(j, i) -= min;
 					}
 					else {
-						matrix(i, j) -= min;
+						cell(i, j) -= min;
 					}
 				}
 			}
 		}
 	}
 
-private:
-
 	inline bool find_uncovered_in_matrix(const double item, size_t &row, size_t &col) const {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
-
-		for (row = 0; row < rows; row++) {
+		for (row = 0; row < size; row++) {
 			if (!row_mask[row]) {
-				for (col = 0; col < columns; col++) {
+				const Data *matrix_row = &matrix[row * size];
+				for (col = 0; col < size; col++) {
 					if (!col_mask[col]) {
-						if (matrix(row, col) == item) {
+						if (matrix_row[col] == item) {
 							return true;
 						}
 					}
@@ -258,8 +276,8 @@ private:
 		return false;
 	}
 
-	bool pair_in_list(const std::pair<size_t, size_t> &needle, const std::list<std::pair<size_t, size_t> > &haystack) {
-		for (std::list<std::pair<size_t, size_t> >::const_iterator i = haystack.begin(); i != haystack.end(); i++) {
+	bool pair_in_list(const std::pair<size_t, size_t> &needle, const std::vector<std::pair<size_t, size_t> > &haystack) {
+		for (auto i = haystack.begin(); i != haystack.end(); i++) {
 			if (needle == *i) {
 				return true;
 			}
@@ -269,17 +287,14 @@ private:
 	}
 
 	int step1() {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
-
-		for (size_t row = 0; row < rows; row++) {
-			for (size_t col = 0; col < columns; col++) {
-				if (0 == matrix(row, col)) {
+		for (size_t row = 0; row < size; row++) {
+			for (size_t col = 0; col < size; col++) {
+				if (0 == cell(row, col)) {
 					for (size_t nrow = 0; nrow < row; nrow++)
-						if (STAR == mask_matrix(nrow, col))
+						if (STAR == mask(nrow, col))
 							goto next_column;
 
-					mask_matrix(row, col) = STAR;
+					mask(row, col) = STAR;
 					goto next_row;
 				}
 			next_column:;
@@ -291,18 +306,16 @@ private:
 	}
 
 	int step2() {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
 		size_t covercount = 0;
 
-		for (size_t row = 0; row < rows; row++)
-			for (size_t col = 0; col < columns; col++)
-				if (STAR == mask_matrix(row, col)) {
+		for (size_t row = 0; row < size; row++)
+			for (size_t col = 0; col < size; col++)
+				if (STAR == mask(row, col)) {
 					col_mask[col] = true;
 					covercount++;
 				}
 
-		if (covercount >= matrix.minsize()) {
+		if (covercount >= size) {
 #ifdef DEBUG
 			std::cout << "Final cover count: " << covercount << std::endl;
 #endif
@@ -310,11 +323,9 @@ private:
 		}
 
 #ifdef DEBUG
-		std::cout << "Munkres matrix has " << covercount << " of " << matrix.minsize() << " Columns covered:" << std::endl;
-		std::cout << matrix << std::endl;
+		std::cout << "Munkres matrix has " << covercount << " of " << size << " Columns covered:" << std::endl;
 #endif
 
-
 		return 3;
 	}
 
@@ -327,14 +338,14 @@ private:
 		3. If a Z* exists, cover this row and uncover the column of the Z*. Return to Step 3.1 to find a new Z
 		*/
 		if (find_uncovered_in_matrix(0, saverow, savecol)) {
-			mask_matrix(saverow, savecol) = PRIME; // prime it.
+			mask(saverow, savecol) = PRIME; // prime it.
 		}
 		else {
 			return 5;
 		}
 
-		for (size_t ncol = 0; ncol < matrix.columns(); ncol++) {
-			if (mask_matrix(saverow, ncol) == STAR) {
+		for (size_t ncol = 0; ncol < size; ncol++) {
+			if (mask(saverow, ncol) == STAR) {
 				row_mask[saverow] = true; //cover this row and
 				col_mask[ncol] = false; // uncover the column containing the starred zero
 				return 3; // repeat
@@ -345,15 +356,12 @@ private:
 	}
 
 	int step4() {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
-
 		// seq contains pairs of row/column values where we have found
 		// either a star or a prime that is part of the ``alternating sequence``.
-		std::list<std::pair<size_t, size_t> > seq;
+		seq.clear();
 		// use saverow, savecol from step 3.
 		std::pair<size_t, size_t> z0(saverow, savecol);
-		seq.insert(seq.end(), z0);
+		seq.push_back(z0);
 
 		// We have to find these two pairs:
 		std::pair<size_t, size_t> z1(-1, -1);
@@ -375,8 +383,8 @@ private:
 		bool madepair;
 		do {
 			madepair = false;
-			for (row = 0; row < rows; row++) {
-				if (mask_matrix(row, col) == STAR) {
+			for (row = 0; row < size; row++) {
+				if (mask(row, col) == STAR) {
 					z1.first = row;
 					z1.second = col;
 					if (pair_in_list(z1, seq)) {
@@ -384,7 +392,7 @@ private:
 					}
 
 					madepair = true;
-					seq.insert(seq.end(), z1);
+					seq.push_back(z1);
 					break;
 				}
 			}
@@ -394,57 +402,46 @@ private:
 
 			madepair = false;
 
-			for (col = 0; col < columns; col++) {
-				if (mask_matrix(row, col) == PRIME) {
+			for (col = 0; col < size; col++) {
+				if (mask(row, col) == PRIME) {
 					z2n.first = row;
 					z2n.second = col;
 					if (pair_in_list(z2n, seq)) {
 						continue;
 					}
 					madepair = true;
-					seq.insert(seq.end(), z2n);
+					seq.push_back(z2n);
 					break;
 				}
 			}
 		} while (madepair);
 
-		for (std::list<std::pair<size_t, size_t> >::iterator i = seq.begin();
-			i != seq.end();
-			i++) {
+		for (auto i = seq.begin(); i != seq.end(); i++) {
 			// 2. Unstar each starred zero of the sequence.
-			if (mask_matrix(i->first, i->second) == STAR)
-				mask_matrix(i->first, i->second) = NORMAL;
+			if (mask(i->first, i->second) == STAR)
+				mask(i->first, i->second) = NORMAL;
 
 			// 3. Star each primed zero of the sequence,
 			// thus increasing the number of starred zeros by one.
-			if (mask_matrix(i->first, i->second) == PRIME)
-				mask_matrix(i->first, i->second) = STAR;
+			if (mask(i->first, i->second) == PRIME)
+				mask(i->first, i->second) = STAR;
 		}
 
 		// 4. Erase all primes, uncover all columns and rows,
-		for (size_t row = 0; row < mask_matrix.rows(); row++) {
-			for (size_t col = 0; col < mask_matrix.columns(); col++) {
-				if (mask_matrix(row, col) == PRIME) {
-					mask_matrix(row, col) = NORMAL;
-				}
+		for (size_t i = 0; i < size * size; i++) {
+			if (mask_matrix[i] == PRIME) {
+				mask_matrix[i] = NORMAL;
 			}
 		}
 
-		for (size_t i = 0; i < rows; i++) {
-			row_mask[i] = false;
-		}
-
-		for (size_t i = 0; i < columns; i++) {
-			col_mask[i] = false;
-		}
+		std::fill(row_mask.begin(), row_mask.end(), false);
+		std::fill(col_mask.begin(), col_mask.end(), false);
 
 		// and return to Step 2.
 		return 2;
 	}
 
 	int step5() {
-		const size_t rows = matrix.rows(),
-			columns = matrix.columns();
 		/*
 		New Zero Manufactures
 
@@ -454,30 +451,30 @@ private:
 		4. Return to Step 3, without altering stars, primes, or covers.
 		*/
 		double h = std::numeric_limits<double>::max();
-		for (size_t row = 0; row < rows; row++) {
+		for (size_t row = 0; row < size; row++) {
 			if (!row_mask[row]) {
-				for (size_t col = 0; col < columns; col++) {
+				for (size_t col = 0; col < size; col++) {
 					if (!col_mask[col]) {
-						if (h > matrix(row, col) && matrix(row, col) != 0) {
-							h = matrix(row, col);
+						if (h > cell(row, col) && cell(row, col) != 0) {
+							h = cell(row, col);
 						}
 					}
 				}
 			}
 		}
 
-		for (size_t row = 0; row < rows; row++) {
+		for (size_t row = 0; row < size; row++) {
 			if (row_mask[row]) {
-				for (size_t col = 0; col < columns; col++) {
-					matrix(row, col) += h;
+				for (size_t col = 0; col < size; col++) {
+					cell(row, col) += h;
 				}
 			}
 		}
 
-		for (size_t col = 0; col < columns; col++) {
+		for (size_t col = 0; col < size; col++) {
 			if (!col_mask[col]) {
-				for (size_t row = 0; row < rows; row++) {
-					matrix(row, col) -= h;
+				for (size_t row = 0; row < size; row++) {
+					cell(row, col) -= h;
 				}
 			}
 		}
@@ -485,12 +482,16 @@ private:
 		return 3;
 	}
 
-	Matrix<int> mask_matrix;
-	Matrix<Data> matrix;
-	bool *row_mask;
-	bool *col_mask;
+	// Square contiguous workspace (size x size, row major), reused between calls
+	std::vector<Data> matrix;
+	std::vector<int> mask_matrix;
+	std::vector<char> row_mask;
+	std::vector<char> col_mask;
+	std::vector<std::pair<size_t, size_t> > seq;
+	size_t size = 0;
+	bool wide = false;
 	size_t saverow = 0, savecol = 0;
 };
 
 
-#endif /* !defined(_MUNKRES_H_) */
\ No newline at end of file
+#endif /* !defined(_MUNKRES_H_) */